@@ -0,0 +1,330 @@
+// ------------------------------------------------------------------------------------------------------------ //
+//  Host-side benchmarks for console_layer
+// ------------------------------------------------------------------------------------------------------------ //
+// Builds src/console.c, unmodified, against the stub pebble.h in this folder and times it natively.
+// Every result is printed as one JSON object per line, so runs can be saved and compared between versions:
+//   {"bench":"write_short","buffer_size":500,"ops":123456,"ns_per_op":81.2,"bytes_per_s":2.9e+08,"chunks_per_s":1.2e+07}
+//
+// Usage: console_bench [name-filter]
+//   BENCH_MIN_MS = how long to run each benchmark for (default 200)
+// ------------------------------------------------------------------------------------------------------------ //
+#include <pebble.h>
+#include "console.h"
+
+#ifndef BENCH_VERSION
+#define BENCH_VERSION "unknown"
+#endif
+
+static const char *bench_filter;
+static uint64_t    bench_min_ns;
+static GBitmap    *bench_image;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Harness
+// ------------------------------------------------------------------------------------------------------------ //
+// A benchmark does `ops` operations on the layer and reports how many text bytes and chunks that wrote
+typedef struct BenchResult { uint64_t bytes, chunks; } BenchResult;
+typedef BenchResult (*BenchFunction)(Layer *console_layer, uint32_t ops);
+typedef void (*BenchSetup)(Layer *console_layer);
+
+static void bench_run(const char *name, int buffer_size, BenchSetup setup, BenchFunction function) {
+  if(bench_filter && !strstr(name, bench_filter)) return;
+
+  Layer *console_layer = console_layer_create_with_buffer_size(GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT), buffer_size);
+  if(setup) setup(console_layer);
+  function(console_layer, 16);  // Warm up
+
+  // Double the number of operations until a run takes long enough to time
+  uint32_t ops = 64;
+  uint64_t elapsed;
+  BenchResult result;
+  for(;;) {
+    stub_reset_stats();
+    uint64_t start = now_ns();
+    result  = function(console_layer, ops);
+    elapsed = now_ns() - start;
+    if(elapsed >= bench_min_ns || ops >= (1u << 30)) break;
+    ops *= 2;
+  }
+
+  double seconds = elapsed / 1e9;
+  printf("{\"bench\":\"%s\",\"version\":\"%s\",\"platform\":\"%s\",\"buffer_size\":%d,\"ops\":%u,\"ns_per_op\":%.1f,"
+         "\"bytes_per_s\":%.4g,\"chunks_per_s\":%.4g,\"measure_calls_per_op\":%.2f,\"draw_text_calls_per_op\":%.2f,"
+         "\"mark_dirty_calls_per_op\":%.2f,\"mallocs\":%u}\n",
+         name, BENCH_VERSION, PBL_IF_ROUND_ELSE("chalk", PBL_IF_COLOR_ELSE("basalt", "aplite")), buffer_size, ops,
+         elapsed / (double)ops, result.bytes / seconds, result.chunks / seconds,
+         stub_stats.measure_calls / (double)ops, stub_stats.draw_text_calls / (double)ops,
+         stub_stats.mark_dirty_calls / (double)ops, stub_stats.mallocs);
+  fflush(stdout);
+
+  console_layer_destroy(console_layer);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Write Benchmarks
+// ------------------------------------------------------------------------------------------------------------ //
+static char short_line[] = "Temperature: 23 C";
+static char long_line[513];  // Same size as the demo's dictation result
+
+static BenchResult write_short(Layer *console_layer, uint32_t ops) {
+  for(uint32_t i=0; i<ops; i++)
+    console_layer_writeln_text(console_layer, short_line);
+  return (BenchResult){.bytes = (uint64_t)ops * (sizeof(short_line) - 1), .chunks = ops};
+}
+
+static BenchResult write_long(Layer *console_layer, uint32_t ops) {
+  for(uint32_t i=0; i<ops; i++)
+    console_layer_writeln_text(console_layer, long_line);
+  return (BenchResult){.bytes = (uint64_t)ops * (sizeof(long_line) - 1), .chunks = ops};
+}
+
+static BenchResult write_styled(Layer *console_layer, uint32_t ops) {
+  GColor colors[] = {GColorRed, GColorBlue, GColorOrange, GColorBlack};
+  GFont fonts[] = {fonts_get_system_font(FONT_KEY_GOTHIC_14), fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD), GFontInherit};
+  for(uint32_t i=0; i<ops; i++)
+    console_layer_write_text_styled(console_layer, short_line, colors[i % 4], i % 2 ? GColorLightGray : GColorInherit, fonts[i % 3], i % 3, WordWrapInherit, true);
+  return (BenchResult){.bytes = (uint64_t)ops * (sizeof(short_line) - 1), .chunks = ops};
+}
+
+static BenchResult write_image(Layer *console_layer, uint32_t ops) {
+  for(uint32_t i=0; i<ops; i++)
+    console_layer_writeln_text_and_image(console_layer, bench_image, short_line);
+  return (BenchResult){.bytes = (uint64_t)ops * (sizeof(short_line) - 1), .chunks = ops};
+}
+
+static BenchResult write_multiline(Layer *console_layer, uint32_t ops) {
+  static char text[] = "one\ntwo\nthree\nfour";
+  for(uint32_t i=0; i<ops; i++)
+    console_layer_writeln_text(console_layer, text);
+  return (BenchResult){.bytes = (uint64_t)ops * (sizeof(text) - 1), .chunks = (uint64_t)ops * 4};
+}
+
+// Every tenth line is an error, with errors kept (see keep_errors), so evicting has to work around them
+static BenchResult write_short_levels(Layer *console_layer, uint32_t ops) {
+  for(uint32_t i=0; i<ops; i++) {
+    console_layer_set_level(console_layer, i % 10 ? ConsoleLayerLevelDebug : ConsoleLayerLevelError);
+    console_layer_writeln_text(console_layer, short_line);
+  }
+  return (BenchResult){.bytes = (uint64_t)ops * (sizeof(short_line) - 1), .chunks = ops};
+}
+
+static BenchResult printf_short(Layer *console_layer, uint32_t ops) {
+  uint64_t bytes = 0;
+  for(uint32_t i=0; i<ops; i++) {
+    console_layer_printfln(console_layer, "Temperature: %d C", (int)(i % 50));
+    bytes += i % 50 < 10 ? 15 : 16;
+  }
+  return (BenchResult){.bytes = bytes, .chunks = ops};
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Render Benchmarks
+// ------------------------------------------------------------------------------------------------------------ //
+// Fills the whole buffer with a mix of lines so every frame has a full screen to draw
+static void fill_layer(Layer *console_layer) {
+  console_layer_set_layer_background_color(console_layer, GColorWhite);
+  for(int i=0; i<400; i++) {
+    if(i % 5 == 4)
+      console_layer_write_text_styled(console_layer, long_line + 400, GColorRed, GColorInherit, GFontInherit, GTextAlignmentInherit, WordWrapInherit, true);
+    else
+      console_layer_printfln(console_layer, "Line %d: %s", i, short_line);
+  }
+}
+
+static void fill_layer_incremental(Layer *console_layer) {
+  console_layer_set_incremental_redraw(console_layer, true);
+  fill_layer(console_layer);
+}
+
+static void compact_text(Layer *console_layer) {
+  console_layer_set_compact_text(console_layer, true);
+}
+
+static void collapse_repeats(Layer *console_layer) {
+  console_layer_set_collapse_repeats(console_layer, true);
+}
+
+static void keep_errors(Layer *console_layer) {
+  console_layer_set_keep_level(console_layer, ConsoleLayerLevelError);
+}
+
+static void fill_layer_compact(Layer *console_layer) {
+  compact_text(console_layer);
+  fill_layer(console_layer);
+}
+
+#ifndef CONSOLE_LAYER_NO_MONO_FONT
+// In the built-in mono font, drawn straight into the frame buffer
+static void fill_layer_mono(Layer *console_layer) {
+  console_layer_set_layer_font(console_layer, CONSOLE_LAYER_FONT_MONO);
+  fill_layer(console_layer);
+}
+#endif
+
+#ifdef PBL_ROUND
+// Word wrapped, with each row as wide as the screen is where it is
+static void fill_layer_round(Layer *console_layer) {
+  console_layer_set_layer_word_wrap(console_layer, true);
+  console_layer_set_round_layout(console_layer, true);
+  fill_layer(console_layer);
+}
+#endif
+
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+// With room in the row cache for a whole screen of rows
+static void fill_layer_cached(Layer *console_layer) {
+  console_layer_set_row_cache_size(console_layer, PBL_DISPLAY_WIDTH * PBL_DISPLAY_HEIGHT + 1024);
+  fill_layer(console_layer);
+}
+#endif
+
+// Redraws a frame where nothing has changed
+static BenchResult render_frame(Layer *console_layer, uint32_t ops) {
+  for(uint32_t i=0; i<ops; i++)
+    stub_render(console_layer);
+  return (BenchResult){0};
+}
+
+// Writes a line, then draws the frame, like a log scrolling by
+static BenchResult render_scroll(Layer *console_layer, uint32_t ops) {
+  for(uint32_t i=0; i<ops; i++) {
+    console_layer_printfln(console_layer, "Line %u: %s", (unsigned)i, short_line);
+    stub_render(console_layer);
+  }
+  return (BenchResult){.bytes = (uint64_t)ops * (sizeof(short_line) - 1), .chunks = ops};
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Find Benchmarks
+// ------------------------------------------------------------------------------------------------------------ //
+// Searches the whole buffer for text that isn't in it
+static BenchResult find_miss(Layer *console_layer, uint32_t ops) {
+  ConsoleMatch match;
+  for(uint32_t i=0; i<ops; i++)
+    console_layer_find(console_layer, "Temperature: 99", &match);
+  return (BenchResult){0};
+}
+
+// Steps back through every match, newest to oldest
+static BenchResult find_all(Layer *console_layer, uint32_t ops) {
+  ConsoleMatch match;
+  for(uint32_t i=0; i<ops; i++)
+    for(bool found = console_layer_find(console_layer, "Line 1", &match); found; found = console_layer_find_previous(console_layer, "Line 1", &match)) {}
+  return (BenchResult){0};
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Export Benchmarks
+// ------------------------------------------------------------------------------------------------------------ //
+// Sends the whole buffer through the stub outbox, which acknowledges every message straight away, so this is the cost
+// of packing the batches on the watch (the phone and Bluetooth are what limit it in practice)
+static BenchResult export_all(Layer *console_layer, uint32_t ops) {
+  for(uint32_t i=0; i<ops; i++)
+    console_layer_export(console_layer, 0, NULL);
+  return (BenchResult){.bytes = stub_stats.outbox_bytes};
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Retention Benchmarks
+// ------------------------------------------------------------------------------------------------------------ //
+// Not timed: writes a mix of log lines until the buffer has gone round several times, then counts the lines still in
+// it (every line starts with one '#', so that's the number of matches)
+static const char *log_lines[] = {
+  "#%d Connected to phone, battery at 84%%",
+  "#%d Temperature: 23 C",
+  "#%d Received message with 12 values",
+  "#%d ERROR: failed to load settings (-3), using the defaults",
+  "#%d Heart rate: 72 bpm",
+  "#%d Sent 3 of 5 messages, waiting for the rest",
+  "#%d Timer fired after 1000 ms",
+  "#%d x=120 y=-45 z=1000",
+  "#%d Heap: 1234 bytes free, 4321 used",
+  "#%d The quick brown fox jumps over the lazy dog",
+};
+
+static void bench_lines_kept(const char *name, int buffer_size, BenchSetup setup) {
+  if(bench_filter && !strstr(name, bench_filter)) return;
+
+  Layer *console_layer = console_layer_create_with_buffer_size(GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT), buffer_size);
+  if(setup) setup(console_layer);
+  for(int i=0; i<buffer_size; i++)
+    console_layer_printfln(console_layer, log_lines[i % (sizeof(log_lines) / sizeof(log_lines[0]))], i);
+
+  uint32_t lines = 0;
+  ConsoleMatch match;
+  for(bool found = console_layer_find(console_layer, "#", &match); found; found = console_layer_find_previous(console_layer, "#", &match))
+    lines++;
+  printf("{\"bench\":\"%s\",\"version\":\"%s\",\"platform\":\"%s\",\"buffer_size\":%d,\"lines_kept\":%u}\n",
+         name, BENCH_VERSION, PBL_IF_ROUND_ELSE("chalk", PBL_IF_COLOR_ELSE("basalt", "aplite")), buffer_size, (unsigned)lines);
+  fflush(stdout);
+
+  console_layer_destroy(console_layer);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Main
+// ------------------------------------------------------------------------------------------------------------ //
+int main(int argc, char *argv[]) {
+  bench_filter = argc > 1 ? argv[1] : NULL;
+  bench_min_ns = (getenv("BENCH_MIN_MS") ? strtoull(getenv("BENCH_MIN_MS"), NULL, 10) : 200) * 1000000;
+  bench_image  = gbitmap_create_with_resource(RESOURCE_ID_SMILE);
+  stub_rasterize = false;  // Only time the console, not the stub's drawing
+  app_message_open(64, app_message_outbox_size_maximum());
+  for(size_t i=0; i<sizeof(long_line) - 1; i++)
+    long_line[i] = i % 9 == 8 ? ' ' : 'a' + i % 26;
+
+  static const int write_sizes[] = {500, 4000};
+  for(size_t s=0; s<sizeof(write_sizes)/sizeof(write_sizes[0]); s++) {
+    bench_run("write_short",     write_sizes[s], NULL, write_short);
+    bench_run("write_long",      write_sizes[s], NULL, write_long);
+    bench_run("write_styled",    write_sizes[s], NULL, write_styled);
+    bench_run("write_image",     write_sizes[s], NULL, write_image);
+    bench_run("write_multiline", write_sizes[s], NULL, write_multiline);
+    bench_run("printf_short",    write_sizes[s], NULL, printf_short);
+    bench_run("write_short_compact", write_sizes[s], compact_text, write_short);
+    bench_run("write_long_compact",  write_sizes[s], compact_text, write_long);
+    bench_run("write_short_repeats", write_sizes[s], collapse_repeats, write_short);
+    bench_run("printf_short_repeats", write_sizes[s], collapse_repeats, printf_short);
+    bench_run("write_short_levels",  write_sizes[s], NULL,        write_short_levels);
+    bench_run("write_short_keep",    write_sizes[s], keep_errors, write_short_levels);
+  }
+
+  static const int render_sizes[] = {500, 2000, 8000};
+  for(size_t s=0; s<sizeof(render_sizes)/sizeof(render_sizes[0]); s++) {
+    bench_run("render_frame",              render_sizes[s], fill_layer,             render_frame);
+    bench_run("render_scroll",             render_sizes[s], fill_layer,             render_scroll);
+    bench_run("render_scroll_incremental", render_sizes[s], fill_layer_incremental, render_scroll);
+    bench_run("render_frame_compact",      render_sizes[s], fill_layer_compact,     render_frame);
+#ifndef CONSOLE_LAYER_NO_MONO_FONT
+    bench_run("render_frame_mono",         render_sizes[s], fill_layer_mono,        render_frame);
+    bench_run("render_scroll_mono",        render_sizes[s], fill_layer_mono,        render_scroll);
+#endif
+#ifdef PBL_ROUND
+    bench_run("render_frame_round",        render_sizes[s], fill_layer_round,       render_frame);
+    bench_run("render_scroll_round",       render_sizes[s], fill_layer_round,       render_scroll);
+#endif
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+    bench_run("render_frame_cached",       render_sizes[s], fill_layer_cached,      render_frame);
+    bench_run("render_scroll_cached",      render_sizes[s], fill_layer_cached,      render_scroll);
+#endif
+    bench_run("find_miss",                 render_sizes[s], fill_layer,             find_miss);
+    bench_run("find_miss_compact",         render_sizes[s], fill_layer_compact,     find_miss);
+    bench_run("find_all",                  render_sizes[s], fill_layer,             find_all);
+    bench_run("export",                    render_sizes[s], fill_layer,             export_all);
+  }
+
+  static const int kept_sizes[] = {500, 2000, 8000};
+  for(size_t s=0; s<sizeof(kept_sizes)/sizeof(kept_sizes[0]); s++) {
+    bench_lines_kept("lines_kept",         kept_sizes[s], NULL);
+    bench_lines_kept("lines_kept_compact", kept_sizes[s], compact_text);
+  }
+
+  gbitmap_destroy(bench_image);
+  return 0;
+}
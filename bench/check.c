@@ -0,0 +1,217 @@
+// ------------------------------------------------------------------------------------------------------------ //
+//  Host-side checks for console_layer
+// ------------------------------------------------------------------------------------------------------------ //
+// Builds src/console.c, unmodified, against the stub pebble.h in this folder and checks that what's written comes back
+// out the same: through export (which unpacks compact text and adds repeat counts like they're drawn), find, and saving
+// to persistent storage (in memory, in the stub) and restoring.
+// console_bench is only for timing; this is what fails when a feature breaks.
+//
+// Usage: console_check          (prints each failed check, exits 1 if there were any)
+// ------------------------------------------------------------------------------------------------------------ //
+#include <pebble.h>
+#include "console.h"
+
+static int check_failures;
+
+#define CHECK(condition) do { if(!(condition)) { printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #condition); check_failures++; } } while(0)
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Export
+// ------------------------------------------------------------------------------------------------------------ //
+// Exports the whole layer and puts what the phone would get in text, each chunk's text followed by '|' instead of its 0
+static char     exported[8192];
+static size_t   exported_length;
+static int      export_finished;
+
+static void export_callback(Layer *console_layer, uint32_t next_seq, bool finished) {export_finished = finished;}
+
+static const char* export_text(Layer *console_layer) {
+  exported_length = 0;
+  export_finished = -1;
+  stub_set_outbox_auto_ack(false);
+  if(!console_layer_export(console_layer, 0, export_callback))
+    return "";
+  while(export_finished < 0) {
+    size_t size;
+    const uint8_t *data = stub_outbox_data(&size);  // Tuples: key (4), type (1), length (2), data; seq then text
+    uint16_t length;
+    memcpy(&length, data + 11 + 5, sizeof(length));
+    for(uint16_t i=0; i<length && exported_length < sizeof(exported) - 1; i++)
+      exported[exported_length++] = data[11 + 7 + i] ? data[11 + 7 + i] : '|';
+    stub_ack_outbox(true);
+  }
+  exported[exported_length] = 0;
+  return exported;
+}
+
+static Layer* check_layer(int buffer_size) {
+  return console_layer_create_with_buffer_size(GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT), buffer_size);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Checks
+// ------------------------------------------------------------------------------------------------------------ //
+static void check_export(void) {
+  Layer *console_layer = check_layer(500);
+  console_layer_writeln_text(console_layer, "one");
+  console_layer_write_text(console_layer, "two ");
+  console_layer_writeln_text(console_layer, "three");
+  console_layer_printfln(console_layer, "four %d", 4);
+  CHECK(strcmp(export_text(console_layer), "one\n|two |three\n|four 4\n|") == 0);
+  CHECK(export_finished == 1);
+  console_layer_destroy(console_layer);
+}
+
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+static void check_compact_text(void) {
+  static char *lines[] = {"Temperature: 23 C", "sensor_id=0x7F status=OK", "caf\xc3\xa9 \xc3\x97 3", "MiXeD CaSe 1234567890", "~`!@#$%^&*()[]{}"};
+  Layer *console_layer = check_layer(500);
+  console_layer_set_compact_text(console_layer, true);
+  char expected[512] = "";
+  for(size_t i=0; i<sizeof(lines) / sizeof(lines[0]); i++) {
+    console_layer_writeln_text(console_layer, lines[i]);
+    strcat(strcat(expected, lines[i]), "\n|");
+  }
+  CHECK(strcmp(export_text(console_layer), expected) == 0);
+  ConsoleMatch match;
+  CHECK(console_layer_find(console_layer, "status=OK", &match) && match.index == 15 && match.length == 9);
+  CHECK(!console_layer_find(console_layer, "status=ok", &match));
+  console_layer_destroy(console_layer);
+}
+#endif
+
+#ifndef CONSOLE_LAYER_NO_FIND
+// Lines of 16 to 36 bytes in a 200 byte buffer, so every few lines one straddles the end of the buffer
+static void check_find_across_wrap(void) {
+  Layer *console_layer = check_layer(200);
+  for(int i=0; i<500; i++) {
+    char line[64], needle[32];
+    snprintf(needle, sizeof(needle), "<%d:%.*s>", i, i % 21, "abcdefghijklmnopqrstu");
+    snprintf(line, sizeof(line), "line %s end", needle);
+    console_layer_writeln_text(console_layer, line);
+    ConsoleMatch match;
+    CHECK(console_layer_find(console_layer, needle, &match) && match.index == 5 && match.length == strlen(needle));
+    if(i > 0) {
+      snprintf(needle, sizeof(needle), "<%d:", i - 1);
+      ConsoleMatch previous = match;
+      CHECK(console_layer_find_previous(console_layer, needle, &previous) && previous.seq + 1 == match.seq);
+    }
+  }
+  console_layer_destroy(console_layer);
+}
+#endif
+
+#ifndef CONSOLE_LAYER_NO_REPEATS
+static void check_repeats(void) {
+  Layer *console_layer = check_layer(500);
+  console_layer_set_collapse_repeats(console_layer, true);
+  console_layer_writeln_text(console_layer, "first");
+  for(int i=0; i<5; i++)
+    console_layer_writeln_text(console_layer, "again");
+  console_layer_printfln(console_layer, "again");  // printf'd repeats count too
+  console_layer_writeln_text(console_layer, "last");
+  CHECK(strcmp(export_text(console_layer), "first\n|again \xc3\x97" "6\n|last\n|") == 0);
+  console_layer_destroy(console_layer);
+}
+#endif
+
+#ifndef CONSOLE_LAYER_NO_LEVELS
+// Errors are kept while debug lines fill the buffer over and over
+static void check_keep_level(void) {
+  Layer *console_layer = check_layer(500);
+  console_layer_set_keep_level(console_layer, ConsoleLayerLevelError);
+  console_layer_set_level(console_layer, ConsoleLayerLevelError);
+  console_layer_writeln_text(console_layer, "error one");
+  console_layer_set_level(console_layer, ConsoleLayerLevelDebug);
+  for(int i=0; i<200; i++) {
+    console_layer_printfln(console_layer, "debug line %d", i);
+    if(i == 100) {
+      console_layer_set_level(console_layer, ConsoleLayerLevelError);
+      console_layer_writeln_text(console_layer, "error two");
+      console_layer_set_level(console_layer, ConsoleLayerLevelDebug);
+    }
+  }
+  const char *text = export_text(console_layer);
+  CHECK(strncmp(text, "error one\n|error two\n|", 22) == 0);  // Kept, oldest first, ahead of what's left of the rest
+  CHECK(strstr(text, "debug line 199\n|") && !strstr(text, "debug line 0\n"));
+#ifndef CONSOLE_LAYER_NO_FIND
+  ConsoleMatch match;
+  CHECK(console_layer_find(console_layer, "error one", &match));
+#endif
+  console_layer_destroy(console_layer);
+}
+#endif
+
+// Saves a layer that's wrapped round its buffer (with an error kept, if there are levels), then restores it into a new one
+static void check_persistence(void) {
+  stub_persist_clear();
+  Layer *console_layer = check_layer(500);
+  CHECK(!console_layer_enable_persistence(console_layer, 100));  // Nothing saved yet
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  console_layer_set_keep_level(console_layer, ConsoleLayerLevelError);
+  console_layer_set_level(console_layer, ConsoleLayerLevelError);
+  console_layer_writeln_text(console_layer, "kept error");
+  console_layer_set_level(console_layer, ConsoleLayerLevelDebug);
+#endif
+  for(int i=0; i<60; i++)
+    console_layer_printfln(console_layer, "saved line %d", i);
+  char saved[sizeof(exported)];
+  strcpy(saved, export_text(console_layer));
+  console_layer_destroy(console_layer);  // Saves what's left
+
+  console_layer = check_layer(500);
+  CHECK(console_layer_enable_persistence(console_layer, 100));
+  CHECK(strcmp(export_text(console_layer), saved) == 0);
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  CHECK(strncmp(saved, "kept error\n|", 12) == 0);
+#endif
+
+  // Carrying on after a restore only saves the blocks that change
+  console_layer_writeln_text(console_layer, "after restore");
+  stub_reset_stats();
+  console_layer_persist_flush(console_layer);
+  CHECK(stub_stats.persist_writes >= 2 && stub_stats.persist_writes < 5);  // Changed blocks and the meta, not all 3 blocks and the styles
+  stub_reset_stats();
+  console_layer_persist_flush(console_layer);
+  CHECK(stub_stats.persist_writes == 1);  // Nothing's changed since: just the meta
+  strcpy(saved, export_text(console_layer));
+  console_layer_destroy(console_layer);
+
+  console_layer = check_layer(500);
+  CHECK(console_layer_enable_persistence(console_layer, 100));
+  CHECK(strcmp(export_text(console_layer), saved) == 0);
+  console_layer_writeln_text(console_layer, "and again");
+#ifndef CONSOLE_LAYER_NO_FIND
+  ConsoleMatch match;
+  CHECK(console_layer_find(console_layer, "after restore", &match) && console_layer_find(console_layer, "saved line 59", &match));
+#endif
+  console_layer_destroy(console_layer);
+
+  // A layer with another buffer size doesn't take it
+  console_layer = check_layer(300);
+  CHECK(!console_layer_enable_persistence(console_layer, 100));
+  console_layer_destroy(console_layer);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Main
+// ------------------------------------------------------------------------------------------------------------ //
+int main(void) {
+  app_message_open(64, 128);
+  check_export();
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+  check_compact_text();
+#endif
+#ifndef CONSOLE_LAYER_NO_FIND
+  check_find_across_wrap();
+#endif
+#ifndef CONSOLE_LAYER_NO_REPEATS
+  check_repeats();
+#endif
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  check_keep_level();
+#endif
+  check_persistence();
+  printf("%s: %d failed\n", check_failures ? "FAIL" : "ok", check_failures);
+  return check_failures ? 1 : 0;
+}
@@ -0,0 +1,20 @@
+// ------------------------------------------------------------------------------------------------------------ //
+//  Memory footprint of console_layer
+// ------------------------------------------------------------------------------------------------------------ //
+// Built by `make footprint`, once per configuration.  Prints one JSON object per line:
+//   {"config":"-DCONSOLE_LAYER_NO_IMAGES","pointer_bits":64,"code_bytes":9000,"layer_bytes":1212}
+// code_bytes (passed in from `size`) is host code, so it's only good for comparing configurations: Thumb-2 is smaller.
+// layer_bytes is everything a layer with the default 500 byte buffer allocates.  The watch has 32 bit pointers, so a
+// 64 bit build overstates it by the pointers (and padding) in the layer's struct.
+// ------------------------------------------------------------------------------------------------------------ //
+#include <pebble.h>
+#include "console.h"
+
+int main(int argc, char *argv[]) {
+  stub_reset_stats();
+  Layer *console_layer = console_layer_create(GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT));
+  printf("{\"config\":\"%s\",\"pointer_bits\":%d,\"code_bytes\":%s,\"layer_bytes\":%u}\n",
+         argc > 1 ? argv[1] : "", (int)sizeof(void*) * 8, argc > 2 ? argv[2] : "0", (unsigned)stub_stats.layer_data_bytes);
+  console_layer_destroy(console_layer);
+  return 0;
+}
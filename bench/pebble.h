@@ -0,0 +1,342 @@
+// ------------------------------------------------------------------------------------------------------------ //
+//  Minimal host-side stand-in for the Pebble SDK's pebble.h
+// ------------------------------------------------------------------------------------------------------------ //
+// Just enough of the SDK for src/console.c (and src/main.c) to compile and run natively on Linux.
+// Drawing calls are counted in stub_stats so benchmarks can report how much work each frame did.  Fills, lines and text
+// are also roughly painted into an 8-bit frame buffer (text as a pattern, not glyphs) unless stub_rasterize is false.
+// Text measurement uses a fixed-pitch model: each glyph is (font height / 2) wide.
+// ------------------------------------------------------------------------------------------------------------ //
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sys/types.h>
+
+#if !defined(PBL_PLATFORM_APLITE) && !defined(PBL_PLATFORM_BASALT) && !defined(PBL_PLATFORM_CHALK)
+  #define PBL_PLATFORM_BASALT
+#endif
+#if defined(PBL_PLATFORM_APLITE)
+  #define PBL_BW
+  #define PBL_RECT
+  #define PBL_DISPLAY_WIDTH  144
+  #define PBL_DISPLAY_HEIGHT 168
+#elif defined(PBL_PLATFORM_CHALK)
+  #define PBL_COLOR
+  #define PBL_ROUND
+  #define PBL_DISPLAY_WIDTH  180
+  #define PBL_DISPLAY_HEIGHT 180
+#else
+  #define PBL_COLOR
+  #define PBL_RECT
+  #define PBL_DISPLAY_WIDTH  144
+  #define PBL_DISPLAY_HEIGHT 168
+#endif
+#define PBL_SDK_3
+
+#if defined(PBL_COLOR)
+  #define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+  #define PBL_IF_BW_ELSE(if_true, if_false) (if_false)
+#else
+  #define PBL_IF_COLOR_ELSE(if_true, if_false) (if_false)
+  #define PBL_IF_BW_ELSE(if_true, if_false) (if_true)
+#endif
+#if defined(PBL_ROUND)
+  #define PBL_IF_ROUND_ELSE(if_true, if_false) (if_true)
+  #define PBL_IF_RECT_ELSE(if_true, if_false) (if_false)
+#else
+  #define PBL_IF_ROUND_ELSE(if_true, if_false) (if_false)
+  #define PBL_IF_RECT_ELSE(if_true, if_false) (if_true)
+#endif
+#define PBL_IF_MICROPHONE_ELSE(if_true, if_false) (if_false)
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Geometry
+// ------------------------------------------------------------------------------------------------------------ //
+typedef struct GPoint { int16_t x, y; } GPoint;
+typedef struct GSize  { int16_t w, h; } GSize;
+typedef struct GRect  { GPoint origin; GSize size; } GRect;
+typedef struct GEdgeInsets { int16_t top, right, bottom, left; } GEdgeInsets;
+
+#define GPoint(x, y) ((GPoint){(x), (y)})
+#define GSize(w, h) ((GSize){(w), (h)})
+#define GRect(x, y, w, h) ((GRect){{(x), (y)}, {(w), (h)}})
+#define GRectZero GRect(0, 0, 0, 0)
+#define GPointZero GPoint(0, 0)
+#define GEdgeInsets1(t) ((GEdgeInsets){(t), (t), (t), (t)})
+#define GEdgeInsets2(v, h) ((GEdgeInsets){(v), (h), (v), (h)})
+#define GEdgeInsets3(t, h, b) ((GEdgeInsets){(t), (h), (b), (h)})
+#define GEdgeInsets4(t, r, b, l) ((GEdgeInsets){(t), (r), (b), (l)})
+#define GEDGEINSETS_PICK(_1, _2, _3, _4, NAME, ...) NAME
+#define GEdgeInsets(...) GEDGEINSETS_PICK(__VA_ARGS__, GEdgeInsets4, GEdgeInsets3, GEdgeInsets2, GEdgeInsets1)(__VA_ARGS__)
+
+GRect grect_inset(GRect rect, GEdgeInsets insets);
+bool  grect_equal(const GRect *a, const GRect *b);
+void  grect_clip(GRect *rect_to_clip, const GRect *rect_clipper);
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Colors
+// ------------------------------------------------------------------------------------------------------------ //
+typedef union GColor8 {
+  uint8_t argb;
+  struct { uint8_t b:2; uint8_t g:2; uint8_t r:2; uint8_t a:2; };
+} GColor8;
+typedef GColor8 GColor;
+
+#define GColorClearARGB8          ((uint8_t)0x00)
+#define GColorBlackARGB8          ((uint8_t)0xC0)
+#define GColorWhiteARGB8          ((uint8_t)0xFF)
+#define GColorRedARGB8            ((uint8_t)0xF0)
+#define GColorBlueARGB8           ((uint8_t)0xC3)
+#define GColorYellowARGB8         ((uint8_t)0xFC)
+#define GColorOrangeARGB8         ((uint8_t)0xF8)
+#define GColorLightGrayARGB8      ((uint8_t)0xEA)
+#define GColorDarkGrayARGB8       ((uint8_t)0xD5)
+#define GColorVividCeruleanARGB8  ((uint8_t)0xCB)
+#define GColorClear               ((GColor8){.argb = GColorClearARGB8})
+#define GColorBlack               ((GColor8){.argb = GColorBlackARGB8})
+#define GColorWhite               ((GColor8){.argb = GColorWhiteARGB8})
+#define GColorRed                 ((GColor8){.argb = GColorRedARGB8})
+#define GColorBlue                ((GColor8){.argb = GColorBlueARGB8})
+#define GColorYellow              ((GColor8){.argb = GColorYellowARGB8})
+#define GColorOrange              ((GColor8){.argb = GColorOrangeARGB8})
+#define GColorLightGray           ((GColor8){.argb = GColorLightGrayARGB8})
+#define GColorDarkGray            ((GColor8){.argb = GColorDarkGrayARGB8})
+#define GColorVividCerulean       ((GColor8){.argb = GColorVividCeruleanARGB8})
+bool gcolor_equal(GColor8 a, GColor8 b);
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Fonts and Text
+// ------------------------------------------------------------------------------------------------------------ //
+typedef struct FontInfo { int16_t height; } FontInfo;
+typedef FontInfo *GFont;
+#define FONT_KEY_GOTHIC_09      "RESOURCE_ID_GOTHIC_09"
+#define FONT_KEY_GOTHIC_14      "RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_14_BOLD "RESOURCE_ID_GOTHIC_14_BOLD"
+#define FONT_KEY_GOTHIC_18      "RESOURCE_ID_GOTHIC_18"
+#define FONT_KEY_GOTHIC_18_BOLD "RESOURCE_ID_GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_24      "RESOURCE_ID_GOTHIC_24"
+GFont fonts_get_system_font(const char *font_key);
+
+typedef enum { GTextAlignmentLeft, GTextAlignmentCenter, GTextAlignmentRight } GTextAlignment;
+typedef enum { GTextOverflowModeWordWrap, GTextOverflowModeTrailingEllipsis, GTextOverflowModeFill } GTextOverflowMode;
+typedef struct GTextAttributes GTextAttributes;
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Bitmaps
+// ------------------------------------------------------------------------------------------------------------ //
+typedef enum { GBitmapFormat1Bit, GBitmapFormat8Bit, GBitmapFormat1BitPalette, GBitmapFormat2BitPalette,
+               GBitmapFormat4BitPalette, GBitmapFormat8BitCircular } GBitmapFormat;
+typedef struct GBitmap {
+  uint8_t      *data;
+  uint16_t      row_size_bytes;
+  GRect         bounds;
+  GBitmapFormat format;
+} GBitmap;
+typedef struct GBitmapDataRowInfo { uint8_t *data; int16_t min_x; int16_t max_x; } GBitmapDataRowInfo;
+
+GBitmap*           gbitmap_create_blank(GSize size, GBitmapFormat format);
+GBitmap*           gbitmap_create_with_resource(uint32_t resource_id);
+void               gbitmap_destroy(GBitmap *bitmap);
+GRect              gbitmap_get_bounds(const GBitmap *bitmap);
+uint8_t*           gbitmap_get_data(const GBitmap *bitmap);
+uint16_t           gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+GBitmapFormat      gbitmap_get_format(const GBitmap *bitmap);
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y);
+#define RESOURCE_ID_SMILE 1
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Graphics Context
+// ------------------------------------------------------------------------------------------------------------ //
+typedef enum { GCornerNone = 0, GCornersAll = 15 } GCornerMask;
+typedef enum { GCompOpAssign, GCompOpAssignInverted, GCompOpOr, GCompOpAnd, GCompOpClear, GCompOpSet } GCompOp;
+
+typedef struct GContext {
+  GPoint   offset;           // screen origin of the layer being drawn
+  GRect    clip;             // screen-space clip of the layer being drawn
+  GColor   fill_color, stroke_color, text_color;
+  GBitmap *frame_buffer;
+  bool     frame_buffer_captured;
+} GContext;
+
+void graphics_context_set_fill_color      (GContext *ctx, GColor color);
+void graphics_context_set_stroke_color    (GContext *ctx, GColor color);
+void graphics_context_set_text_color      (GContext *ctx, GColor color);
+void graphics_context_set_stroke_width    (GContext *ctx, uint8_t width);
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode);
+void graphics_fill_rect        (GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_draw_line        (GContext *ctx, GPoint p0, GPoint p1);
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect);
+void graphics_draw_text        (GContext *ctx, const char *text, const GFont font, const GRect box,
+                                const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                                GTextAttributes *text_attributes);
+GSize graphics_text_layout_get_content_size(const char *text, const GFont font, const GRect box,
+                                            const GTextOverflowMode overflow_mode, const GTextAlignment alignment);
+GBitmap* graphics_capture_frame_buffer(GContext *ctx);
+GBitmap* graphics_capture_frame_buffer_format(GContext *ctx, GBitmapFormat format);
+bool     graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer);
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Layers and Windows
+// ------------------------------------------------------------------------------------------------------------ //
+typedef struct Layer Layer;
+typedef struct Window Window;
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+struct Layer {
+  GRect           frame, bounds;
+  bool            hidden, clips;
+  LayerUpdateProc update_proc;
+  Layer          *parent, *first_child, *next_sibling;
+  Window         *window;
+  void           *data;
+};
+
+Layer* layer_create(GRect frame);
+Layer* layer_create_with_data(GRect frame, size_t data_size);
+void   layer_destroy(Layer *layer);
+void*  layer_get_data(const Layer *layer);
+GRect  layer_get_frame(const Layer *layer);
+GRect  layer_get_bounds(const Layer *layer);
+void   layer_set_frame(Layer *layer, GRect frame);
+void   layer_set_bounds(Layer *layer, GRect bounds);
+void   layer_mark_dirty(Layer *layer);
+void   layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void   layer_set_clips(Layer *layer, bool clips);
+bool   layer_get_hidden(const Layer *layer);
+void   layer_set_hidden(Layer *layer, bool hidden);
+void   layer_add_child(Layer *parent, Layer *child);
+void   layer_remove_from_parent(Layer *child);
+Layer* layer_get_parent(const Layer *child);
+Window* layer_get_window(const Layer *layer);
+GRect  layer_convert_rect_to_screen(const Layer *layer, GRect rect);
+
+typedef struct WindowHandlers { void (*load)(Window *window); void (*appear)(Window *window);
+                                void (*disappear)(Window *window); void (*unload)(Window *window); } WindowHandlers;
+typedef void* ClickRecognizerRef;
+typedef void (*ClickHandler)(ClickRecognizerRef recognizer, void *context);
+typedef void (*ClickConfigProvider)(void *context);
+typedef enum { BUTTON_ID_BACK, BUTTON_ID_UP, BUTTON_ID_SELECT, BUTTON_ID_DOWN } ButtonId;
+
+Window* window_create(void);
+void    window_destroy(Window *window);
+Layer*  window_get_root_layer(const Window *window);
+void    window_set_window_handlers(Window *window, WindowHandlers handlers);
+void    window_set_background_color(Window *window, GColor color);
+void    window_set_click_config_provider(Window *window, ClickConfigProvider provider);
+void    window_stack_push(Window *window, bool animated);
+Window* window_stack_get_top_window(void);
+bool    window_is_loaded(Window *window);
+void    window_single_click_subscribe(ButtonId button_id, ClickHandler handler);
+void    window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler, ClickHandler up_handler);
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Timers, Time, Heap, Logging
+// ------------------------------------------------------------------------------------------------------------ //
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+bool      app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms);
+void      app_timer_cancel(AppTimer *timer);
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+size_t   heap_bytes_free(void);
+size_t   heap_bytes_used(void);
+
+typedef enum { APP_LOG_LEVEL_ERROR = 1, APP_LOG_LEVEL_WARNING = 50, APP_LOG_LEVEL_INFO = 100,
+               APP_LOG_LEVEL_DEBUG = 200, APP_LOG_LEVEL_DEBUG_VERBOSE = 255 } AppLogLevel;
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...);
+#define APP_LOG(level, fmt, ...) app_log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+void app_event_loop(void);
+void light_enable(bool enable);
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Persistent Storage
+// ------------------------------------------------------------------------------------------------------------ //
+#define PERSIST_DATA_MAX_LENGTH 256
+#define E_DOES_NOT_EXIST (-4)
+typedef int status_t;
+bool     persist_exists(const uint32_t key);
+int      persist_get_size(const uint32_t key);
+int      persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size);
+int      persist_write_data(const uint32_t key, const void *data, const size_t size);
+status_t persist_delete(const uint32_t key);
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  AppMessage / Dictionary
+// ------------------------------------------------------------------------------------------------------------ //
+typedef enum { APP_MSG_OK = 0, APP_MSG_SEND_TIMEOUT = 2, APP_MSG_SEND_REJECTED = 4, APP_MSG_NOT_CONNECTED = 8,
+               APP_MSG_BUSY = 64, APP_MSG_BUFFER_OVERFLOW = 128, APP_MSG_INVALID_ARGS = 1024,
+               APP_MSG_INTERNAL_ERROR = 2048, APP_MSG_OUT_OF_MEMORY = 4096 } AppMessageResult;
+typedef enum { DICT_OK = 0, DICT_NOT_ENOUGH_STORAGE = 2, DICT_INVALID_ARGS = 4 } DictionaryResult;
+typedef struct DictionaryIterator { uint8_t *cursor, *end; uint16_t count; } DictionaryIterator;
+typedef void (*AppMessageOutboxSent)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator *iterator, AppMessageResult reason, void *context);
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+uint32_t         app_message_outbox_size_maximum(void);
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+AppMessageOutboxSent   app_message_register_outbox_sent(AppMessageOutboxSent sent_callback);
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback);
+void*            app_message_set_context(void *context);
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t * const data, const uint16_t size);
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value);
+uint32_t         dict_calc_buffer_size(const uint8_t tuple_count, ...);
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Watch Info and Dictation (for src/main.c)
+// ------------------------------------------------------------------------------------------------------------ //
+typedef enum { WATCH_INFO_MODEL_UNKNOWN, WATCH_INFO_MODEL_PEBBLE_ORIGINAL, WATCH_INFO_MODEL_PEBBLE_STEEL,
+               WATCH_INFO_MODEL_PEBBLE_TIME, WATCH_INFO_MODEL_PEBBLE_TIME_STEEL,
+               WATCH_INFO_MODEL_PEBBLE_TIME_ROUND_14, WATCH_INFO_MODEL_PEBBLE_TIME_ROUND_20 } WatchInfoModel;
+WatchInfoModel watch_info_get_model(void);
+
+typedef struct DictationSession DictationSession;
+typedef enum { DictationSessionStatusSuccess } DictationSessionStatus;
+typedef void (*DictationSessionStatusCallback)(DictationSession *session, DictationSessionStatus status, char *transcription, void *context);
+DictationSession* dictation_session_create(uint32_t buffer_size, DictationSessionStatusCallback callback, void *callback_context);
+void              dictation_session_destroy(DictationSession *session);
+int               dictation_session_start(DictationSession *session);
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Stub-only hooks (not part of the Pebble SDK)
+// ------------------------------------------------------------------------------------------------------------ //
+typedef struct StubStats {
+  uint32_t mallocs;            // heap allocations made through malloc()
+  uint32_t layer_data_bytes;   // bytes asked for by layer_create_with_data()
+  uint32_t measure_calls;      // graphics_text_layout_get_content_size()
+  uint32_t draw_text_calls;    // graphics_draw_text()
+  uint32_t draw_text_bytes;
+  uint32_t fill_rect_calls;
+  uint32_t draw_bitmap_calls;
+  uint32_t draw_line_calls;
+  uint32_t mark_dirty_calls;
+  uint32_t frame_buffer_captures;
+  uint32_t set_text_color_calls;
+  uint32_t persist_writes;
+  uint32_t persist_bytes;
+  uint32_t outbox_sends;
+  uint32_t outbox_bytes;
+} StubStats;
+extern StubStats stub_stats;
+extern bool      stub_trace;       // print every draw call to stdout
+extern bool      stub_rasterize;   // paint fills, lines and text into the frame buffer (default true)
+extern GBitmap   *stub_frame_buffer; // what stub_render draws into (created on first render)
+
+void*  stub_malloc(size_t size);
+#define malloc(size) stub_malloc(size)
+
+void   stub_reset_stats(void);
+void   stub_render(Layer *layer);              // Runs the layer's update proc against the stub frame buffer
+void   stub_advance_time(uint32_t ms);         // Moves the virtual clock forward and fires due AppTimers
+void   stub_set_heap_bytes_free(size_t bytes);
+void   stub_set_outbox_auto_ack(bool auto_ack); // true: outbox_sent fires synchronously on send
+void   stub_ack_outbox(bool success);          // Fires the pending outbox sent/failed callback
+const uint8_t* stub_outbox_data(size_t *size); // Tuples (key, type, length, data) of the last message sent
+void   stub_persist_clear(void);
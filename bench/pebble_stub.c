@@ -0,0 +1,560 @@
+// ------------------------------------------------------------------------------------------------------------ //
+//  Host-side implementation of the stub Pebble SDK (see pebble.h)
+// ------------------------------------------------------------------------------------------------------------ //
+#include "pebble.h"
+#undef malloc
+
+StubStats stub_stats;
+bool      stub_trace;
+bool      stub_rasterize = true;
+
+void* stub_malloc(size_t size) {
+  stub_stats.mallocs++;
+  return malloc(size);
+}
+
+void stub_reset_stats(void) {
+  memset(&stub_stats, 0, sizeof(stub_stats));
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Geometry and Colors
+// ------------------------------------------------------------------------------------------------------------ //
+GRect grect_inset(GRect rect, GEdgeInsets insets) {
+  GRect r = GRect(rect.origin.x + insets.left, rect.origin.y + insets.top,
+                  rect.size.w - insets.left - insets.right, rect.size.h - insets.top - insets.bottom);
+  if(r.size.w < 0 || r.size.h < 0) return GRectZero;
+  return r;
+}
+
+bool grect_equal(const GRect *a, const GRect *b) {
+  return a->origin.x == b->origin.x && a->origin.y == b->origin.y && a->size.w == b->size.w && a->size.h == b->size.h;
+}
+
+void grect_clip(GRect *rect_to_clip, const GRect *rect_clipper) {
+  int16_t x0 = rect_to_clip->origin.x > rect_clipper->origin.x ? rect_to_clip->origin.x : rect_clipper->origin.x;
+  int16_t y0 = rect_to_clip->origin.y > rect_clipper->origin.y ? rect_to_clip->origin.y : rect_clipper->origin.y;
+  int16_t x1 = rect_to_clip->origin.x + rect_to_clip->size.w < rect_clipper->origin.x + rect_clipper->size.w ?
+               rect_to_clip->origin.x + rect_to_clip->size.w : rect_clipper->origin.x + rect_clipper->size.w;
+  int16_t y1 = rect_to_clip->origin.y + rect_to_clip->size.h < rect_clipper->origin.y + rect_clipper->size.h ?
+               rect_to_clip->origin.y + rect_to_clip->size.h : rect_clipper->origin.y + rect_clipper->size.h;
+  *rect_to_clip = GRect(x0, y0, x1 > x0 ? x1 - x0 : 0, y1 > y0 ? y1 - y0 : 0);
+}
+
+bool gcolor_equal(GColor8 a, GColor8 b) {
+  return a.argb == b.argb;
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Fonts and Text
+// ------------------------------------------------------------------------------------------------------------ //
+static FontInfo stub_fonts[] = {{9}, {14}, {18}, {24}, {28}};
+
+GFont fonts_get_system_font(const char *font_key) {
+  if(strstr(font_key, "_09")) return &stub_fonts[0];
+  if(strstr(font_key, "_14")) return &stub_fonts[1];
+  if(strstr(font_key, "_18")) return &stub_fonts[2];
+  if(strstr(font_key, "_24")) return &stub_fonts[3];
+  return &stub_fonts[4];
+}
+
+GSize graphics_text_layout_get_content_size(const char *text, const GFont font, const GRect box,
+                                            const GTextOverflowMode overflow_mode, const GTextAlignment alignment) {
+  (void)overflow_mode; (void)alignment;
+  stub_stats.measure_calls++;
+  int16_t glyph_w = font ? font->height / 2 : 7, line_h = font ? font->height : 14;
+  int16_t per_line = box.size.w > glyph_w ? box.size.w / glyph_w : 1;
+  int lines = 0, widest = 0, col = 0;
+  if(!text || !*text) return GSize(0, 0);
+  for(const char *c = text; ; c++) {
+    if(*c == 0 || *c == '\n') {
+      lines += col ? (col + per_line - 1) / per_line : 1;
+      if(col > widest) widest = col;
+      col = 0;
+      if(*c == 0 || c[1] == 0) break;
+    } else if(((uint8_t)*c & 0xC0) != 0x80) {
+      col++;
+    }
+  }
+  if(widest > per_line) widest = per_line;
+  return GSize(widest * glyph_w, lines * line_h);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Bitmaps
+// ------------------------------------------------------------------------------------------------------------ //
+GBitmap* gbitmap_create_blank(GSize size, GBitmapFormat format) {
+  GBitmap *bitmap = calloc(1, sizeof(GBitmap));
+  bitmap->format = format;
+  bitmap->bounds = GRect(0, 0, size.w, size.h);
+  bitmap->row_size_bytes = format == GBitmapFormat1Bit ? ((size.w + 31) / 32) * 4 : size.w;
+  bitmap->data = calloc(1, (size_t)bitmap->row_size_bytes * (size.h ? size.h : 1));
+  return bitmap;
+}
+
+GBitmap* gbitmap_create_with_resource(uint32_t resource_id) {
+  (void)resource_id;
+  return gbitmap_create_blank(GSize(20, 20), PBL_IF_COLOR_ELSE(GBitmapFormat8Bit, GBitmapFormat1Bit));
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+  if(bitmap) { free(bitmap->data); free(bitmap); }
+}
+
+GRect         gbitmap_get_bounds(const GBitmap *bitmap)        {return bitmap->bounds;}
+uint8_t*      gbitmap_get_data(const GBitmap *bitmap)          {return bitmap->data;}
+uint16_t      gbitmap_get_bytes_per_row(const GBitmap *bitmap) {return bitmap->row_size_bytes;}
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap)        {return bitmap->format;}
+
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap *bitmap, uint16_t y) {
+  return (GBitmapDataRowInfo){.data = bitmap->data + (size_t)y * bitmap->row_size_bytes,
+                              .min_x = 0, .max_x = bitmap->bounds.size.w - 1};
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Graphics Context
+// ------------------------------------------------------------------------------------------------------------ //
+void graphics_context_set_fill_color      (GContext *ctx, GColor color) {ctx->fill_color = color;}
+void graphics_context_set_stroke_color    (GContext *ctx, GColor color) {ctx->stroke_color = color;}
+void graphics_context_set_text_color      (GContext *ctx, GColor color) {ctx->text_color = color; stub_stats.set_text_color_calls++;}
+void graphics_context_set_stroke_width    (GContext *ctx, uint8_t width) {(void)ctx; (void)width;}
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) {(void)ctx; (void)mode;}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+  (void)corner_radius; (void)corner_mask;
+  stub_stats.fill_rect_calls++;
+  if(stub_trace) printf("fill (%d,%d %dx%d) c=%02x\n", rect.origin.x, rect.origin.y, rect.size.w, rect.size.h, ctx->fill_color.argb);
+  GBitmap *fb = ctx->frame_buffer;
+  if(!stub_rasterize || !fb || fb->format != GBitmapFormat8Bit) return;
+  for(int y = rect.origin.y; y < rect.origin.y + rect.size.h; y++)
+    for(int x = rect.origin.x; x < rect.origin.x + rect.size.w; x++) {
+      int sx = x + ctx->offset.x, sy = y + ctx->offset.y;
+      if(sx < ctx->clip.origin.x || sy < ctx->clip.origin.y ||
+         sx >= ctx->clip.origin.x + ctx->clip.size.w || sy >= ctx->clip.origin.y + ctx->clip.size.h) continue;
+      fb->data[sy * fb->row_size_bytes + sx] = ctx->fill_color.argb;
+    }
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+  stub_stats.draw_line_calls++;
+  GBitmap *fb = ctx->frame_buffer;
+  if(!stub_rasterize || !fb || fb->format != GBitmapFormat8Bit || p0.y != p1.y) return;
+  for(int x = p0.x; x <= p1.x; x++) {
+    int sx = x + ctx->offset.x, sy = p0.y + ctx->offset.y;
+    if(sx < ctx->clip.origin.x || sy < ctx->clip.origin.y ||
+       sx >= ctx->clip.origin.x + ctx->clip.size.w || sy >= ctx->clip.origin.y + ctx->clip.size.h) continue;
+    fb->data[sy * fb->row_size_bytes + sx] = ctx->stroke_color.argb;
+  }
+}
+
+void graphics_draw_bitmap_in_rect(GContext *ctx, const GBitmap *bitmap, GRect rect) {
+  (void)ctx; (void)bitmap; (void)rect;
+  stub_stats.draw_bitmap_calls++;
+  if(stub_trace) printf("bitmap (%d,%d %dx%d)\n", rect.origin.x, rect.origin.y, rect.size.w, rect.size.h);
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, const GFont font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        GTextAttributes *text_attributes) {
+  (void)ctx; (void)font; (void)box; (void)overflow_mode; (void)alignment; (void)text_attributes;
+  stub_stats.draw_text_calls++;
+  stub_stats.draw_text_bytes += strlen(text);
+  if(stub_trace) printf("text (%d,%d %dx%d) c=%02x '%s'\n", box.origin.x, box.origin.y, box.size.w, box.size.h, ctx->text_color.argb, text);
+  GBitmap *fb = ctx->frame_buffer;
+  size_t len = strlen(text);
+  if(!stub_rasterize || !fb || fb->format != GBitmapFormat8Bit || !len) return;
+  for(int y = box.origin.y + 3; y < box.origin.y + box.size.h; y++)  // glyphs start 3px into the box
+    for(int x = box.origin.x; x < box.origin.x + box.size.w; x++) {
+      int sx = x + ctx->offset.x, sy = y + ctx->offset.y;
+      if(sx < ctx->clip.origin.x || sy < ctx->clip.origin.y ||
+         sx >= ctx->clip.origin.x + ctx->clip.size.w || sy >= ctx->clip.origin.y + ctx->clip.size.h) continue;
+      if(((x - box.origin.x) + (y - box.origin.y)) % 3) continue;
+      fb->data[sy * fb->row_size_bytes + sx] = ctx->text_color.argb ^ (uint8_t)text[(x - box.origin.x) % len];
+    }
+}
+
+GBitmap* graphics_capture_frame_buffer(GContext *ctx) {
+  if(ctx->frame_buffer_captured) return NULL;
+  stub_stats.frame_buffer_captures++;
+  ctx->frame_buffer_captured = true;
+  return ctx->frame_buffer;
+}
+
+GBitmap* graphics_capture_frame_buffer_format(GContext *ctx, GBitmapFormat format) {
+  return ctx->frame_buffer && ctx->frame_buffer->format == format ? graphics_capture_frame_buffer(ctx) : NULL;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+  (void)buffer;
+  ctx->frame_buffer_captured = false;
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Layers and Windows
+// ------------------------------------------------------------------------------------------------------------ //
+struct Window {
+  Layer          root;
+  WindowHandlers handlers;
+  bool           loaded;
+};
+static Window *stub_top_window;
+
+Layer* layer_create(GRect frame) {
+  return layer_create_with_data(frame, 0);
+}
+
+Layer* layer_create_with_data(GRect frame, size_t data_size) {
+  Layer *layer = calloc(1, sizeof(Layer));
+  layer->frame = frame;
+  layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+  layer->data = data_size ? calloc(1, data_size) : NULL;
+  stub_stats.layer_data_bytes += data_size;
+  return layer;
+}
+
+void layer_destroy(Layer *layer) {
+  if(!layer) return;
+  layer_remove_from_parent(layer);
+  free(layer->data);
+  free(layer);
+}
+
+void*  layer_get_data(const Layer *layer)   {return layer->data;}
+GRect  layer_get_frame(const Layer *layer)  {return layer->frame;}
+GRect  layer_get_bounds(const Layer *layer) {return layer->bounds;}
+bool   layer_get_hidden(const Layer *layer) {return layer->hidden;}
+void   layer_set_hidden(Layer *layer, bool hidden) {layer->hidden = hidden;}
+void   layer_set_clips(Layer *layer, bool clips) {layer->clips = clips;}
+void   layer_set_bounds(Layer *layer, GRect bounds) {layer->bounds = bounds;}
+void   layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {layer->update_proc = update_proc;}
+void   layer_mark_dirty(Layer *layer) {(void)layer; stub_stats.mark_dirty_calls++;}
+
+void layer_set_frame(Layer *layer, GRect frame) {
+  if(layer->bounds.origin.x == 0 && layer->bounds.origin.y == 0 &&
+     layer->bounds.size.w == layer->frame.size.w && layer->bounds.size.h == layer->frame.size.h)
+    layer->bounds.size = frame.size;
+  layer->frame = frame;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  layer_remove_from_parent(child);
+  child->parent = parent;
+  child->window = parent->window;
+  Layer **link = &parent->first_child;
+  while(*link) link = &(*link)->next_sibling;
+  *link = child;
+}
+
+void layer_remove_from_parent(Layer *child) {
+  if(!child->parent) return;
+  for(Layer **link = &child->parent->first_child; *link; link = &(*link)->next_sibling)
+    if(*link == child) { *link = child->next_sibling; break; }
+  child->parent = NULL;
+  child->next_sibling = NULL;
+  child->window = NULL;
+}
+
+Layer* layer_get_parent(const Layer *child) {
+  return child->parent;
+}
+
+Window* layer_get_window(const Layer *layer) {
+  return layer->window;
+}
+
+GRect layer_convert_rect_to_screen(const Layer *layer, GRect rect) {
+  for(const Layer *l = layer; l; l = l->parent) {
+    rect.origin.x += l->frame.origin.x - l->bounds.origin.x;
+    rect.origin.y += l->frame.origin.y - l->bounds.origin.y;
+  }
+  return rect;
+}
+
+Window* window_create(void) {
+  Window *window = calloc(1, sizeof(Window));
+  window->root.frame = window->root.bounds = GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT);
+  window->root.window = window;
+  return window;
+}
+
+void    window_destroy(Window *window) {
+  if(window && window->loaded && window->handlers.unload) window->handlers.unload(window);
+  if(stub_top_window == window) stub_top_window = NULL;
+  free(window);
+}
+Layer*  window_get_root_layer(const Window *window) {return (Layer*)&window->root;}
+void    window_set_window_handlers(Window *window, WindowHandlers handlers) {window->handlers = handlers;}
+void    window_set_background_color(Window *window, GColor color) {(void)window; (void)color;}
+void    window_set_click_config_provider(Window *window, ClickConfigProvider provider) {(void)window; (void)provider;}
+Window* window_stack_get_top_window(void) {return stub_top_window;}
+bool    window_is_loaded(Window *window) {return window->loaded;}
+void    window_single_click_subscribe(ButtonId button_id, ClickHandler handler) {(void)button_id; (void)handler;}
+void    window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler, ClickHandler up_handler) {
+  (void)button_id; (void)delay_ms; (void)down_handler; (void)up_handler;
+}
+
+void window_stack_push(Window *window, bool animated) {
+  (void)animated;
+  stub_top_window = window;
+  if(!window->loaded && window->handlers.load) window->handlers.load(window);
+  window->loaded = true;
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Rendering
+// ------------------------------------------------------------------------------------------------------------ //
+GBitmap *stub_frame_buffer;
+
+void stub_render(Layer *layer) {
+  if(!stub_frame_buffer)
+    stub_frame_buffer = gbitmap_create_blank(GSize(PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT), GBitmapFormat8Bit);
+  if(!layer->update_proc || layer->hidden) return;
+  GContext ctx = {.frame_buffer = stub_frame_buffer};
+  ctx.clip = layer_convert_rect_to_screen(layer, layer->bounds);
+  ctx.offset = ctx.clip.origin;
+  layer->update_proc(layer, &ctx);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Timers, Time, Heap, Logging
+// ------------------------------------------------------------------------------------------------------------ //
+struct AppTimer {
+  uint64_t          due_ms;
+  AppTimerCallback  callback;
+  void             *data;
+  AppTimer         *next;
+};
+static AppTimer *stub_timers;
+static uint64_t  stub_clock_offset_ms;
+static size_t    stub_heap_free = 16 * 1024;
+
+static uint64_t stub_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000 + stub_clock_offset_ms;
+}
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  AppTimer *timer = calloc(1, sizeof(AppTimer));
+  timer->due_ms = stub_now_ms() + timeout_ms;
+  timer->callback = callback;
+  timer->data = callback_data;
+  timer->next = stub_timers;
+  stub_timers = timer;
+  return timer;
+}
+
+bool app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms) {
+  for(AppTimer *t = stub_timers; t; t = t->next)
+    if(t == timer) { t->due_ms = stub_now_ms() + new_timeout_ms; return true; }
+  return false;
+}
+
+void app_timer_cancel(AppTimer *timer) {
+  for(AppTimer **link = &stub_timers; *link; link = &(*link)->next)
+    if(*link == timer) { *link = timer->next; free(timer); return; }
+}
+
+void stub_advance_time(uint32_t ms) {
+  stub_clock_offset_ms += ms;
+  uint64_t now = stub_now_ms();
+  bool fired = true;
+  while(fired) {
+    fired = false;
+    for(AppTimer **link = &stub_timers; *link; link = &(*link)->next)
+      if((*link)->due_ms <= now) {
+        AppTimer *timer = *link;
+        *link = timer->next;
+        timer->callback(timer->data);
+        free(timer);
+        fired = true;
+        break;
+      }
+  }
+}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+  uint64_t now = stub_now_ms();
+  if(tloc) *tloc = (time_t)(now / 1000);
+  if(out_ms) *out_ms = now % 1000;
+  return now % 1000;
+}
+
+size_t heap_bytes_free(void) {return stub_heap_free;}
+size_t heap_bytes_used(void) {return 0;}
+void   stub_set_heap_bytes_free(size_t bytes) {stub_heap_free = bytes;}
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...) {
+  if(!getenv("STUB_APP_LOG")) return;
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "[%d] %s:%d> ", log_level, src_filename, src_line_number);
+  vfprintf(stderr, fmt, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+void app_event_loop(void) {}
+void light_enable(bool enable) {(void)enable;}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Persistent Storage (in memory)
+// ------------------------------------------------------------------------------------------------------------ //
+#define STUB_PERSIST_KEYS 256
+static struct { bool used; uint32_t key; uint16_t size; uint8_t data[PERSIST_DATA_MAX_LENGTH]; } stub_persist[STUB_PERSIST_KEYS];
+
+static int stub_persist_find(uint32_t key, bool create) {
+  for(int i = 0; i < STUB_PERSIST_KEYS; i++)
+    if(stub_persist[i].used && stub_persist[i].key == key) return i;
+  if(create)
+    for(int i = 0; i < STUB_PERSIST_KEYS; i++)
+      if(!stub_persist[i].used) { stub_persist[i].used = true; stub_persist[i].key = key; return i; }
+  return -1;
+}
+
+bool persist_exists(const uint32_t key) {return stub_persist_find(key, false) >= 0;}
+
+int persist_get_size(const uint32_t key) {
+  int i = stub_persist_find(key, false);
+  return i < 0 ? E_DOES_NOT_EXIST : stub_persist[i].size;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+  int i = stub_persist_find(key, false);
+  if(i < 0) return E_DOES_NOT_EXIST;
+  size_t n = buffer_size < stub_persist[i].size ? buffer_size : stub_persist[i].size;
+  memcpy(buffer, stub_persist[i].data, n);
+  return (int)n;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+  int i = stub_persist_find(key, true);
+  if(i < 0) return -1;
+  size_t n = size < PERSIST_DATA_MAX_LENGTH ? size : PERSIST_DATA_MAX_LENGTH;
+  memcpy(stub_persist[i].data, data, n);
+  stub_persist[i].size = n;
+  stub_stats.persist_writes++;
+  stub_stats.persist_bytes += n;
+  return (int)n;
+}
+
+status_t persist_delete(const uint32_t key) {
+  int i = stub_persist_find(key, false);
+  if(i < 0) return E_DOES_NOT_EXIST;
+  stub_persist[i].used = false;
+  return 0;
+}
+
+void stub_persist_clear(void) {
+  memset(stub_persist, 0, sizeof(stub_persist));
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  AppMessage (loopback: sent messages are counted and acknowledged by the test)
+// ------------------------------------------------------------------------------------------------------------ //
+#define STUB_OUTBOX_SIZE 2048
+static uint8_t                stub_outbox[STUB_OUTBOX_SIZE];
+static uint32_t               stub_outbox_size = 256;
+static DictionaryIterator     stub_outbox_iter;
+static bool                   stub_outbox_open, stub_outbox_pending, stub_outbox_auto_ack = true;
+static AppMessageOutboxSent   stub_sent_callback;
+static AppMessageOutboxFailed stub_failed_callback;
+static void                  *stub_app_message_context;
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+  (void)size_inbound;
+  stub_outbox_size = size_outbound < STUB_OUTBOX_SIZE ? size_outbound : STUB_OUTBOX_SIZE;
+  return APP_MSG_OK;
+}
+
+uint32_t app_message_outbox_size_maximum(void) {return STUB_OUTBOX_SIZE;}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+  if(stub_outbox_open || stub_outbox_pending) return APP_MSG_BUSY;
+  stub_outbox_iter = (DictionaryIterator){.cursor = stub_outbox, .end = stub_outbox + stub_outbox_size};
+  stub_outbox_open = true;
+  *iterator = &stub_outbox_iter;
+  return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+  if(!stub_outbox_open) return APP_MSG_INVALID_ARGS;
+  stub_outbox_open = false;
+  stub_outbox_pending = true;
+  stub_stats.outbox_sends++;
+  stub_stats.outbox_bytes += stub_outbox_iter.cursor - stub_outbox;
+  if(stub_outbox_auto_ack) stub_ack_outbox(true);
+  return APP_MSG_OK;
+}
+
+void stub_ack_outbox(bool success) {
+  if(!stub_outbox_pending) return;
+  stub_outbox_pending = false;
+  if(success && stub_sent_callback) stub_sent_callback(&stub_outbox_iter, stub_app_message_context);
+  if(!success && stub_failed_callback) stub_failed_callback(&stub_outbox_iter, APP_MSG_SEND_TIMEOUT, stub_app_message_context);
+}
+
+void stub_set_outbox_auto_ack(bool auto_ack) {stub_outbox_auto_ack = auto_ack;}
+
+const uint8_t* stub_outbox_data(size_t *size) {
+  *size = stub_outbox_iter.cursor - stub_outbox;
+  return stub_outbox;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+  AppMessageOutboxSent previous = stub_sent_callback;
+  stub_sent_callback = sent_callback;
+  return previous;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+  AppMessageOutboxFailed previous = stub_failed_callback;
+  stub_failed_callback = failed_callback;
+  return previous;
+}
+
+void* app_message_set_context(void *context) {
+  void *previous = stub_app_message_context;
+  stub_app_message_context = context;
+  return previous;
+}
+
+static DictionaryResult stub_dict_write(DictionaryIterator *iter, uint32_t key, const void *data, uint16_t size) {
+  if(iter->cursor + 7 + size > iter->end) return DICT_NOT_ENOUGH_STORAGE;
+  memcpy(iter->cursor, &key, 4);
+  iter->cursor[4] = 0;
+  memcpy(iter->cursor + 5, &size, 2);
+  memcpy(iter->cursor + 7, data, size);
+  iter->cursor += 7 + size;
+  iter->count++;
+  return DICT_OK;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t * const data, const uint16_t size) {
+  return stub_dict_write(iter, key, data, size);
+}
+
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value) {
+  return stub_dict_write(iter, key, &value, sizeof(value));
+}
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...) {
+  va_list args;
+  va_start(args, tuple_count);
+  uint32_t total = 1;
+  for(int i = 0; i < tuple_count; i++) total += 7 + va_arg(args, uint32_t);
+  va_end(args);
+  return total;
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+//  Watch Info and Dictation
+// ------------------------------------------------------------------------------------------------------------ //
+WatchInfoModel watch_info_get_model(void) {return WATCH_INFO_MODEL_UNKNOWN;}
+DictationSession* dictation_session_create(uint32_t buffer_size, DictationSessionStatusCallback callback, void *callback_context) {
+  (void)buffer_size; (void)callback; (void)callback_context;
+  return NULL;
+}
+void dictation_session_destroy(DictationSession *session) {(void)session;}
+int  dictation_session_start(DictationSession *session) {(void)session; return 0;}
@@ -2,95 +2,332 @@
 // ------------------------------------------------------------------------------------------------------------ //
 //  Data Structure
 // ------------------------------------------------------------------------------------------------------------ //
-// APLITE APP MEMORY USAGE: Total footprint in RAM:         3353 bytes / 24KB
-// BASALT APP MEMORY USAGE: Total footprint in RAM:         3353 bytes / 64KB
-// CHALK  APP MEMORY USAGE: Total footprint in RAM:         3353 bytes / 64KB
+// Footprint, measured with `make footprint` (64 bit host build at -Os, so only good for comparing configurations:
+// the watch's Thumb-2 code is smaller, and its 4 byte pointers make each layer a bit smaller too)
+//                                                        Code    RAM per layer (500 byte buffer, with index and scratch)
+//   Everything                                         36809    1952
+//   CONSOLE_LAYER_NO_IMAGES                            35816    1952
+//   CONSOLE_LAYER_NO_PER_CHUNK_STYLE                   33791    1672  (no style table)
+//   CONSOLE_LAYER_NO_HEADER + NO_BORDER                34835    1920
+//   CONSOLE_LAYER_NO_COMPACT_TEXT                      34775    1952
+//   CONSOLE_LAYER_NO_REPEATS                           34913    1952
+//   CONSOLE_LAYER_NO_LEVELS                            35358    1824
+//   CONSOLE_LAYER_NO_FIND                              34252    1944
+//   CONSOLE_LAYER_NO_MONO_FONT                         33492    1952
+//   CONSOLE_LAYER_NO_ROW_CACHE                         33885    1936
+//   All four                                           26886    1512  (and every chunk is 1 byte smaller: no style byte, so no compact text)
 // ------------------------------------------------------- 
 /*
 ------------------------------------------------------------------------------------------------------------------------------------------------------
 Buffer holds:
-       0 = Head/Tail EOF terminator
        0 = End of string
-       Text is written from last char to first char forwards in memory.
-       This is instead of it being written (from last char to first char) forwards causing it to be stored and read backwards
-       It writes last char to first char in case the string written is larger than the buffer.  So the head eats the tail.
+       Chunks are written in reading order, each one just after the last, wrapping around to the start of the buffer.
+       Each piece of a chunk is copied in with memcpy (twice if it straddles the end of the buffer).
+       Before a chunk is written, the oldest chunks are evicted (whole) until there's room for it, so the tail is never garbage.
+       A chunk bigger than the whole buffer is cut short.
        
 ------------------------------------------------------------------------------------------------------------------------------------------------------
  Buffer Description
 --------------------------------------
-              v=pos points to EOF            |       Second Chunk        |        Third Chunk          |
- Data Layout: 0|SBCFONTIMAGstring...string/n0|SBCFONTIMAGstring...string0|SBCFONTIMAGstring...string/n0|0000000---til end of buffer
-           EOF^ ^                         ^ ^0 terminated string
-        Settings|                         | optional newline (10) at end of string if writeln
-       0 = 1 byte:  Circular Buffer Begin/End "EOF" split point (must = 0)
-    IMAG = 4 bytes: Image Pointer (optional, if settings)
-    FONT = 4 bytes: Font Pointer (optional, if settings bit b=1)
-       C = 1 byte:  Text Color (optional, if settings bit c=1)
-       B = 1 byte:  Text Background Color (optional, if settings bit d=1)
-       S = 1 byte:  Settings Byte
-       0babcdefgh = Settings Byte
+              |   First Chunk      |   Second Chunk |    Third Chunk     |
+ Data Layout: |SIMAGstring...str/n0|Sstring...string0|SIMAGstring...str/n0|0000000000000
+              ^                ^ ^0 terminated string                     ^=pos: where the next chunk's first byte will go
+         Style|                | optional newline (10) at end of string if writeln
+    IMAG = 4 bytes: Image Pointer, as it is in memory (optional, if style bit a=1)
+       S = 1 byte:  Style Byte (left out if compiled with both CONSOLE_LAYER_NO_IMAGES and NO_PER_CHUNK_STYLE)
+       0baklliiii = Style Byte
          a        1 bit:  Image Included?             [1 = yes (text too), 0 = no (just text)]
-          b       1 bit:  Background Color Specified? [0 = no (inherit from console_layer), 1 = yes]
-           c      1 bit:  Text Color Specified?       [0 = no (inherit from console_layer), 1 = yes]
-            d     1 bit:  Font Specified?             [0 = no (inherit from console_layer), 1 = yes]
+          k       1 bit:  Compact Text?               [1 = bytes 128-255 of the text stand for tokens, 0 = plain text]
+           ll     2 bits: Level                       [00=debug, 01=info, 10=warning, 11=error]
+             iiii 4 bits: Style ID                    [index into the layer's style table, 0 with CONSOLE_LAYER_NO_PER_CHUNK_STYLE]
+
+------------------------------------------------------------------------------------------------------------------------------------------------------
+ Style Table
+--------------------------------------
+Each layer keeps a small table of the distinct styles (colors, font, alignment and word wrap) its chunks are written in,
+so each chunk only needs one byte to say how it looks, and drawing a run of chunks in the same style decodes it once.
+Styles are added as they're first written in (or up front with console_layer_register_style, which also pins them so
+they're never replaced).  When the table is full, the style that was last used longest ago is replaced, and the oldest
+chunks are evicted until none are left using it.
+  Settings Byte (of each style)
+       0b0000efgh
              ef   2 bits: Alignment                   [00=left, 01=center, 10=right,   11=inherit]
                gh 2 bits: Word Wrap                   [00=no,   01=yes,    10=inherit, 11=inherit]
                g  1 bit:  Inherit Word Wrap?          [0 = no (change), 1 = yes (inherit)]
                 h 1 bit:  bit g = 1: Unused. bit g = 0: Word Wrap? (0 = no, 1 = yes)
                           "Word Wrap no" means one line of text displayed only (ends in "..." if too long)
                           "Word Wrap yes" means wrap long (and \n inside string) text to multiple lines
+  Colors of GColorClear and a NULL font inherit from the console_layer
+
+------------------------------------------------------------------------------------------------------------------------------------------------------
+ Compact Text
+--------------------------------------
+With console_layer_set_compact_text on, plain ASCII text is stored with each of 128 common letter pairs and short words
+(compact_tokens) packed into one byte, 0b1ttttttt = token t.  Every other byte (including the newline, the 0s between
+fragments and the terminating 0) is stored as it is.  Text with any byte over 127 (UTF-8) is never packed.
 
 ------------------------------------------------------------------------------------------------------------------------------------------------------
  Note that the Buffer can wrap around
 --------------------------------------
 
-         Third |         Fourth Chunk        | |        First Chunk          |       Second Chunk        | Third Chunk (wraps around end of buffer)
-Buffer: "ing\n0|SBCFONTIMAGstring...strSBCFON|0|SBCFONTIMAGstring...string/n0|SBCFONTIMAGstring...string0|SBCFONTIMAGstring...str"
-                                              ^ = EOF: This 0 is where pos points, signifing the beginning/end "EOF" point
-                                              
-Notice that in this example that the fourth chunk is invalid since it's been partially overwritten
-  
+         Third |                         |       First Chunk           |       Second Chunk        | Third Chunk (wraps around end of buffer)
+Buffer: "ing\n0|0000000000000000000000000|SIMAGstring...string/n0|Sstring...string0|SIMAGstring...str"
+               ^ = pos
+Free space between pos and the oldest chunk is never read: chunks are only found through the chunk index
+
+------------------------------------------------------------------------------------------------------------------------------------------------------
+ Chunk Index
+--------------------------------------
+A small circular array beside the buffer holds where each chunk starts, how long it is and how tall it was measured to be
+(and, with console_layer_set_collapse_repeats, how many times over it's been written).
+console_layer_update walks it newest to oldest and jumps straight to each visible chunk, so drawing costs the same no matter
+how big the buffer is.  There's room for one entry per INDEX_BYTES_PER_CHUNK bytes of buffer; if a burst of tiny chunks
+fills the index before the buffer, the oldest chunk is evicted just the same.
 ------------------------------------------------------------------------------------------------------------------------------------------------------  
 */
 
+#define LAYOUT_UNMEASURED      -1   // console_chunk.height when the chunk hasn't been measured yet
+#ifdef PBL_ROUND
+  #define ROUND_UNLAID         INT16_MIN  // console_chunk.round_bottom when it has to be laid out again
+  #define FORGET_ROUND_LAYOUT(chunk) ((chunk)->round_bottom = ROUND_UNLAID)
+#else
+  #define FORGET_ROUND_LAYOUT(chunk) ((void)(chunk))
+#endif
+#define INDEX_BYTES_PER_CHUNK  16   // Chunk index gets one entry per this many bytes of buffer
+
+typedef struct console_chunk {
+  uint16_t           offset;            // Position of the chunk's style byte in the buffer
+  uint16_t           length;            // Bytes from the style byte to the string terminating 0, inclusive
+  int16_t            height;            // Measured text height, or LAYOUT_UNMEASURED
+#ifdef PBL_ROUND
+  uint8_t            width_min;         // Widths the height holds for: the widest line of the text, to the width it was
+  uint8_t            width_max;         //   wrapped to (they only differ with round layout, see console_layer_get_text_height)
+  int16_t            round_bottom;      // Round layout: bottom of the row it was last laid out starting (or ROUND_UNLAID),
+  uint8_t            round_x;           //   and where the row went across (see console_layer_get_round_text_height)
+  uint8_t            round_width;
+#endif
+#ifndef CONSOLE_LAYER_NO_REPEATS
+  uint16_t           repeats;           // Times it's been written again straight after itself (see console_layer_repeat_chunk)
+#endif
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  uint32_t           seq;               // Sequence number (kept chunks outlive the ones after them, so they don't follow on)
+#endif
+} console_chunk;
+
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+#ifndef CONSOLE_LAYER_MAX_STYLES
+#define CONSOLE_LAYER_MAX_STYLES 16         // Size of each layer's style table (at most 16, see STYLE_ID_BITS)
+#endif
+#if CONSOLE_LAYER_MAX_STYLES > 16
+#error "CONSOLE_LAYER_MAX_STYLES can't be more than 16"
+#endif
+
+typedef struct console_style {
+  GFont              font;
+  GColor             text_color;
+  GColor             background_color;
+  uint8_t            settings;          // Alignment and word wrap bits
+  bool               pinned;            // Registered with console_layer_register_style, never replaced
+} console_style;
+#endif
+
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+#ifndef CONSOLE_LAYER_ROW_CACHE_ROWS
+#define CONSOLE_LAYER_ROW_CACHE_ROWS 24     // Most rows the row cache holds, however small they are
+#endif
+
+// A row as it was drawn (see console_layer_set_row_cache_size)
+typedef struct console_cached_row {
+  uint32_t           seq;               // Newest chunk on the row
+  uint32_t           first_seq;         // Oldest chunk on the row
+  uint16_t           length;            // The newest chunk's length when it was drawn
+#ifndef CONSOLE_LAYER_NO_REPEATS
+  uint16_t           repeats;           //   and its repeat count
+#endif
+  int16_t            bottom;            // Where the row's bottom was (only checked with round layout, which depends on it)
+  int16_t            height;
+  uint8_t            pixels[];          // The row's part of the frame buffer, bounds width by height, 8 bits each
+} console_cached_row;
+
+// Bytes a row takes up in the arena (rounded up so the next one starts aligned)
+#define CACHED_ROW_SIZE(width, height) ((sizeof(console_cached_row) + (size_t)(width) * (height) + 3) & ~(size_t)3)
+
+// Everything the rows in the cache were drawn with.  If any of it changes, they're all thrown out.
+typedef struct console_row_cache_key {
+  uint32_t           style;             // Hash of the layer's settings (see console_layer_get_style_hash)
+  int16_t            width;             // Width of the rows' bounds
+  int16_t            text_x;            // Where the text goes across them
+  int16_t            text_width;
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  uint8_t            view_level;
+#endif
+#ifndef CONSOLE_LAYER_NO_FIND
+  uint32_t           highlight_seq;
+  uint16_t           highlight_index;
+  uint16_t           highlight_length;
+#endif
+#ifdef PBL_ROUND
+  bool               round;
+  GRect              round_frame;
+#endif
+} console_row_cache_key;
+
+typedef struct console_row_cache {
+  console_row_cache_key key;
+  GRect              clip;              // Rows area on screen this frame: rows are only kept or copied back if they're all
+                                        //   inside it (empty = not this frame)
+  uint8_t            count;
+  console_cached_row *rows[CONSOLE_LAYER_ROW_CACHE_ROWS];  // Oldest first, pointing into the arena
+  uint8_t            arena[];           // row_cache_size bytes the rows go in one after another, wrapping round to the start
+} console_row_cache;
+#endif
+
 typedef struct console_data_struct {
   bool               dirty_layer_automatically;
-  bool               border_enabled;
-  bool               header_enabled;
   bool               layer_word_wrap;
   
+#ifndef CONSOLE_LAYER_NO_BORDER
+  bool               border_enabled;
   GColor             border_color;
   uint8_t            border_thickness;
+#endif
   
+#ifndef CONSOLE_LAYER_NO_HEADER
+  bool               header_enabled;
   GColor             header_background_color;
   GColor             header_text_color;
   GFont              header_font;
   GTextAlignment     header_text_alignment;
   char              *header_text;
+#endif
   
   GColor             layer_background_color;
   GColor             layer_text_color;
   GFont              layer_font;
   GTextAlignment     layer_alignment;
 
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
   uint8_t            word_wrap;
   GColor             background_color;
   GColor             text_color;
   GFont              font;
   GTextAlignment     alignment;
 
-  size_t             buffer_size;
+  // Style table (see console_layer_intern_style)
+  console_style      styles[CONSOLE_LAYER_MAX_STYLES];
+  uint8_t            style_count;       // Styles in use are styles[0] to styles[style_count - 1]
+  uint8_t            last_style;        // Style the last chunk was written in, checked first
+#endif
+
+  // Layout cache: chunk heights are kept in the chunk index so console_layer_update doesn't re-measure every frame
+  int16_t            layout_width;      // Layer settings the cached heights were measured with.  If any of these
+  GFont              layout_font;       //   change, every cached height is thrown out (see console_layer_check_layout_cache)
+  GTextAlignment     layout_alignment;
+  bool               layout_word_wrap;
+#ifdef PBL_ROUND
+  bool               round_layout;      // Wrap each row to the chord of the screen across it (see console_layer_set_round_layout)
+  GRect              round_frame;       // Where the rows area was on screen last frame (the chords are worked out from it)
+#endif
+#if !defined(CONSOLE_LAYER_NO_MONO_FONT) || !defined(CONSOLE_LAYER_NO_ROW_CACHE)
+  GRect              screen_bounds;     // Where the layer is on screen this frame (the mono font and the row cache go straight to the frame buffer)
+#endif
+
+  // Scrollback (see console_layer_scroll_by)
+  bool               follow_tail;       // Keep the newest row at the bottom of the layer
+  uint32_t           scroll_seq;        // When not following the tail, sequence number of the newest chunk on the bottom row
+#ifndef CONSOLE_LAYER_NO_FIND
+  ConsoleMatch       highlight;         // Match drawn highlighted (length 0 = none, see console_layer_find)
+#endif
+
+  // Batched writes (see console_layer_begin_batch)
+  uint8_t            batch_depth;       // How many batches are open
+  bool               batch_dirty;       // Something in the batch needs the layer redrawn
+
+  // Redraw rate cap (see console_layer_set_max_fps)
+  uint8_t            max_fps;           // 0 = no cap
+  AppTimer          *redraw_timer;      // Pending redraw, if one's been put off
+  uint32_t           last_redraw_ms;    // When the layer was last marked dirty
+
+  // Persistence (see console_layer_enable_persistence)
+  uint32_t           persist_key;       // First persistent storage key the layer is mirrored to
+  uint8_t           *persist_dirty;     // One bit per block of the index and buffer changed since the last flush (NULL = off)
+  bool               persist_styles_dirty;
+  AppTimer          *persist_timer;     // Pending flush
+
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+  bool               compact_text;      // Pack text written from now on (see console_layer_set_compact_text)
+#endif
+#ifndef CONSOLE_LAYER_NO_REPEATS
+  bool               collapse_repeats;  // Count lines written exactly like the newest instead of storing them again
+#endif
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  uint8_t            level;             // Level chunks are written at (see console_layer_set_level)
+  uint8_t            view_level;        // Chunks below this level aren't drawn
+  uint8_t            keep_level;        // Chunks at this level or above outlive less important ones (see console_layer_evict_unkept_chunk)
+#endif
+
+  // Storage (see console_layer_set_buffer_size and console_layer_create_in_pool)
+  ConsoleLayerPool  *pool;              // Pool the index and buffer are in (NULL = in the layer's own data or the heap)
+  uint8_t           *heap_storage;      // Index, buffer and scratch, once grown past the layer's own data (NULL = not)
+  uint16_t           inline_size;       // Buffer size the layer's own data has room for
+  uint16_t           min_size;          // Buffer size quota, in a pool or with adaptive sizing
+  uint16_t           max_size;
+  uint16_t           heap_headroom;     // Adaptive sizing: heap bytes to leave free (0 = off)
+  uint32_t           last_write_ms;     // When the layer was last written to, to tell idle layers from busy ones
+
+  // Incremental redraw: what was on screen at the end of the last frame (see console_layer_draw_new_rows)
+  bool               incremental_redraw;
+  bool               redraw_full;       // Next frame has to repaint everything
+  uint32_t           drawn_seq;         // chunk_seq when the last frame was drawn
+  uint32_t           drawn_oldest_seq;  // Sequence number of the oldest chunk on screen
+  uint32_t           drawn_style;       // Hash of the layer, header and border settings
+  uint32_t           drawn_checksum;    // Checksum of the rows area of the frame buffer
+  GRect              drawn_bounds;      // Where the layer was on screen
+  int16_t            drawn_header_height;
+#ifndef CONSOLE_LAYER_NO_REPEATS
+  uint16_t           drawn_repeats;     // Repeat count of the newest chunk
+  int16_t            drawn_tail_height; // Height of the newest row (with collapse_repeats on)
+#endif
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+  size_t             row_cache_size;    // Most bytes of rows to keep (0 = off, see console_layer_set_row_cache_size)
+  console_row_cache *row_cache;         // Rows as they were drawn (NULL = off)
+#endif
+
+  // Chunk index (circular, oldest chunk at chunk_first)
+  console_chunk     *chunks;
+  uint16_t           chunk_capacity;
+  uint16_t           chunk_first;
+  uint16_t           chunk_count;
+  uint32_t           chunk_seq;         // Sequence number the next chunk written will get (newest chunk is chunk_seq - 1)
+
+#ifdef CONSOLE_LAYER_STATS
+  ConsoleLayerStats  stats;
+#endif
+
+  size_t             buffer_size;       // Must fit in a uint16_t (see console_chunk)
+  size_t             buffer_used;       // Sum of the lengths of every chunk in the index
   uintptr_t          pos;
+  char              *scratch;           // buffer_size bytes for text that wraps around the end of the buffer, or is compact
   char              *buffer;
 } console_data_struct;
 
 #define DEFAULT_BUFFER_SIZE 500  // Size (in bytes) of text buffer per layer
 
-                                          // 0bABCDEFGH = Settings Byte
+#ifdef CONSOLE_LAYER_STATS
+  #define COUNT_STAT(console_data, stat, count) ((console_data)->stats.stat += (count))
+#else
+  #define COUNT_STAT(console_data, stat, count) ((void)(console_data))
+#endif
+
+                                          // 0bAKLLIIII = Style Byte (start of every chunk)
 #define             IMAGE_BIT  0b10000000 //   A        1 bit:  Image Included? (1=yes, 0=no)
-#define  BACKGROUND_COLOR_BIT  0b01000000 //    B       1 bit:  Background Color Specified? (0 = no (inherit from console_layer), 1 = yes)
-#define        TEXT_COLOR_BIT  0b00100000 //     C      1 bit:  Text Color Specified?       (0 = no (inherit from console_layer), 1 = yes)
-#define              FONT_BIT  0b00010000 //      D     1 bit:  Font Specified?             (0 = no (inherit from console_layer), 1 = yes)
+#define           COMPACT_BIT  0b01000000 //    K       1 bit:  Compact Text? (1=yes, 0=no)
+#define            LEVEL_BITS  0b00110000 //     LL     2 bits: Level (ConsoleLayerLevel)
+#define           LEVEL_SHIFT  4
+#define         STYLE_ID_BITS  0b00001111 //       IIII 4 bits: Style ID (index into console_data->styles)
+#define              NO_STYLE  0xFF       // Not a style ID
+
+                                          // 0b0000EFGH = Settings Byte (of a style)
 #define         ALIGNMENT_BITS 0b00001100 //       EF   2 bits: Alignment                   [00=left, 01=center, 10=right,   11=inherit]
 #define         WORD_WRAP_BITS 0b00000011 //         GH 2 bits: Word Wrap                   [00=no,   01=yes,    10=inherit, 11=inherit]
 #define WORD_WRAP_INHERIT_BIT  0b00000010 //         G  1 bit:  Inherit Word Wrap?          (0 = no:change, 1 = yes:inherit)
@@ -99,19 +336,134 @@ typedef struct console_data_struct {
 
 #define NULL_IMAGE NULL
 
+// Chunk header: the style byte (unless there's nothing for it to say), then the image pointer if the chunk has one
+#if defined(CONSOLE_LAYER_NO_IMAGES) && defined(CONSOLE_LAYER_NO_PER_CHUNK_STYLE)
+  #define STYLE_BYTE_LENGTH 0
+#else
+  #define STYLE_BYTE_LENGTH 1
+#endif
+#ifdef CONSOLE_LAYER_NO_IMAGES
+  #define HAS_IMAGE(style_byte) false
+#else
+  #define HAS_IMAGE(style_byte) ((style_byte)&IMAGE_BIT)
+#endif
+#define MAX_HEADER_LENGTH (STYLE_BYTE_LENGTH + (HAS_IMAGE(IMAGE_BIT) ? sizeof(GBitmap*) : 0))
+#ifdef CONSOLE_LAYER_NO_COMPACT_TEXT
+  #define IS_COMPACT(style_byte) false
+#else
+  #define IS_COMPACT(style_byte) ((style_byte)&COMPACT_BIT)
+#endif
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  #define GET_LEVEL(style_byte) (((style_byte)&LEVEL_BITS) >> LEVEL_SHIFT)
+#endif
+
+// Write style passed on by the unstyled write functions
+#ifdef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  #define WRITE_STYLE(console_data)       ((void)(console_data), GColorInherit), GColorInherit, GFontInherit, GTextAlignmentInherit, WordWrapInherit
+  #define WRITE_IMAGE_STYLE(console_data) ((void)(console_data), GColorInherit), GTextAlignmentInherit
+#else
+  #define WRITE_STYLE(console_data)       (console_data)->text_color, (console_data)->background_color, (console_data)->font, (console_data)->alignment, (console_data)->word_wrap
+  #define WRITE_IMAGE_STYLE(console_data) (console_data)->background_color, (console_data)->alignment
+#endif
+
+// Internal margin for the layer (TODO: Maybe add this as an external setting?)
+#define MARGIN_TOP_BOTTOM 0
+#define MARGIN_LEFT_RIGHT 1
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Batch Writes
+// ------------------------------------------------------------------------------------------------------------ //
+// Inside a batch the layer is only marked dirty once, at the end, and text written with the same style as the newest
+// chunk on the same row carries that chunk on instead of starting a new one with a header of its own.
+
+// Writes to a layer that's hidden (or inside one that is), or whose window isn't on top, only go in the buffer: there's
+// no need to mark it dirty or lay the new text out until it's on screen, and the system redraws it when it's shown.
+static bool console_layer_is_visible(Layer *console_layer) {
+  for(Layer *layer = console_layer; layer; layer = layer_get_parent(layer))
+    if(layer_get_hidden(layer))
+      return false;
+  Window *window = layer_get_window(console_layer);
+  return !window || window==window_stack_get_top_window();
+}
+
+static uint32_t console_layer_now_ms(void) {
+  time_t   s;
+  uint16_t ms = time_ms(&s, NULL);
+  return (uint32_t)s * 1000 + ms;
+}
+
+static void console_layer_redraw_timer_callback(void *data) {
+  Layer *console_layer = (Layer*)data;
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_data->redraw_timer   = NULL;
+  console_data->last_redraw_ms = console_layer_now_ms();
+  layer_mark_dirty(console_layer);
+}
+
+// Marks the layer dirty now, or if it was marked less than 1/max_fps ago, puts it off until then.  Everything asked for
+// in the meantime is drawn together when the timer fires.
+static void console_layer_request_redraw(Layer *console_layer) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(!console_layer_is_visible(console_layer))
+    return;
+  if(console_data->max_fps==0) {
+    layer_mark_dirty(console_layer);
+    return;
+  }
+  if(console_data->redraw_timer)  // Already coming
+    return;
+  uint32_t now      = console_layer_now_ms();
+  uint32_t interval = 1000 / console_data->max_fps;
+  uint32_t elapsed  = now - console_data->last_redraw_ms;
+  if(elapsed >= interval) {       // First write in a while draws straight away
+    console_data->last_redraw_ms = now;
+    layer_mark_dirty(console_layer);
+  } else {
+    console_data->redraw_timer = app_timer_register(interval - elapsed, console_layer_redraw_timer_callback, console_layer);
+  }
+}
+
+// Marks the layer dirty if it's set to be dirtied automatically, or when the batch ends if one's open
+static void console_layer_mark_dirty(Layer *console_layer) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(!console_data->dirty_layer_automatically)
+    return;
+  if(console_data->batch_depth>0)
+    console_data->batch_dirty = true;
+  else
+    console_layer_request_redraw(console_layer);
+}
+
+void console_layer_begin_batch(Layer *console_layer) {
+  ((console_data_struct*)layer_get_data(console_layer))->batch_depth++;
+}
+
+void console_layer_end_batch(Layer *console_layer) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(console_data->batch_depth==0 || --console_data->batch_depth>0)
+    return;
+  if(console_data->batch_dirty)
+    console_layer_request_redraw(console_layer);
+  console_data->batch_dirty = false;
+}
+
 // ------------------------------------------------------------------------------------------------------------ //
 // Gets
 // ------------------------------------------------------------------------------------------------------------ //
+#ifndef CONSOLE_LAYER_NO_BORDER
 int            console_layer_get_border_thickness       (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->border_thickness;}
 bool           console_layer_get_border_enabled         (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->border_enabled;}
 GColor         console_layer_get_border_color           (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->border_color;}
+#endif
 
+#ifndef CONSOLE_LAYER_NO_HEADER
 GColor         console_layer_get_header_background_color(Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->header_background_color;}
 GTextAlignment console_layer_get_header_text_alignment  (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->header_text_alignment;}
 GColor         console_layer_get_header_text_color      (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->header_text_color;}
 bool           console_layer_get_header_enabled         (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->header_enabled;}
 GFont          console_layer_get_header_font            (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->header_font;}
 char*          console_layer_get_header_text            (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->header_text;}
+#endif
 
 GColor         console_layer_get_layer_background_color (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->layer_background_color;}
 GColor         console_layer_get_layer_text_color       (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->layer_text_color;}
@@ -119,28 +471,55 @@ GTextAlignment console_layer_get_layer_alignment        (Layer *console_layer) {
 bool           console_layer_get_layer_word_wrap        (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->layer_word_wrap;}
 GFont          console_layer_get_layer_font             (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->layer_font;}
 
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
 GColor         console_layer_get_background_color       (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->background_color;}
 GColor         console_layer_get_text_color             (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->text_color;}
 GTextAlignment console_layer_get_alignment              (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->alignment;}
 int            console_layer_get_word_wrap              (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->word_wrap;}
 GFont          console_layer_get_font                   (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->font;}
+#endif
 
 bool           console_layer_get_dirty_automatically    (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->dirty_layer_automatically;}
+bool           console_layer_get_incremental_redraw     (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->incremental_redraw;}
+bool           console_layer_get_follow_tail            (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->follow_tail;}
+uint8_t        console_layer_get_max_fps                (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->max_fps;}
+int            console_layer_get_buffer_size            (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->buffer_size;}
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+bool           console_layer_get_compact_text           (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->compact_text;}
+#endif
+#ifndef CONSOLE_LAYER_NO_REPEATS
+bool           console_layer_get_collapse_repeats       (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->collapse_repeats;}
+#endif
+#ifdef PBL_ROUND
+bool           console_layer_get_round_layout           (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->round_layout;}
+#endif
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+size_t         console_layer_get_row_cache_size         (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->row_cache_size;}
+#endif
+#ifndef CONSOLE_LAYER_NO_LEVELS
+ConsoleLayerLevel console_layer_get_level               (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->level;}
+ConsoleLayerLevel console_layer_get_view_level          (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->view_level;}
+ConsoleLayerLevel console_layer_get_keep_level          (Layer *console_layer) {return ((console_data_struct*)layer_get_data(console_layer))->keep_level;}
+#endif
 
 
 // ------------------------------------------------------------------------------------------------------------ //
 // Sets
 // ------------------------------------------------------------------------------------------------------------ //
+#ifndef CONSOLE_LAYER_NO_BORDER
 void console_layer_set_border_thickness       (Layer *console_layer, int    border_thickness)                 {((console_data_struct*)layer_get_data(console_layer))->border_thickness = border_thickness;}
 void console_layer_set_border_enabled         (Layer *console_layer, bool   border_enabled)                   {((console_data_struct*)layer_get_data(console_layer))->border_enabled   = border_enabled;}
 void console_layer_set_border_color           (Layer *console_layer, GColor border_color)                     {((console_data_struct*)layer_get_data(console_layer))->border_color     = border_color;}
+#endif
 
+#ifndef CONSOLE_LAYER_NO_HEADER
 void console_layer_set_header_background_color(Layer *console_layer, GColor         header_background_color)  {((console_data_struct*)layer_get_data(console_layer))->header_background_color = header_background_color;}
 void console_layer_set_header_text_alignment  (Layer *console_layer, GTextAlignment header_text_alignment)    {((console_data_struct*)layer_get_data(console_layer))->header_text_alignment   = header_text_alignment;}
 void console_layer_set_header_text_color      (Layer *console_layer, GColor         header_text_color)        {((console_data_struct*)layer_get_data(console_layer))->header_text_color       = header_text_color;}
 void console_layer_set_header_enabled         (Layer *console_layer, bool           header_enabled)           {((console_data_struct*)layer_get_data(console_layer))->header_enabled          = header_enabled;}
 void console_layer_set_header_font            (Layer *console_layer, GFont          header_font)              {((console_data_struct*)layer_get_data(console_layer))->header_font             = header_font;}
 void console_layer_set_header_text            (Layer *console_layer, char          *header_text)              {((console_data_struct*)layer_get_data(console_layer))->header_text             = header_text;}
+#endif
 
 void console_layer_set_layer_background_color (Layer *console_layer, GColor         layer_background_color)   {((console_data_struct*)layer_get_data(console_layer))->layer_background_color = layer_background_color;}
 void console_layer_set_layer_text_color       (Layer *console_layer, GColor         layer_text_color)         {((console_data_struct*)layer_get_data(console_layer))->layer_text_color       = layer_text_color;}
@@ -148,16 +527,34 @@ void console_layer_set_layer_alignment        (Layer *console_layer, GTextAlignm
 void console_layer_set_layer_word_wrap        (Layer *console_layer, bool           layer_word_wrap)          {((console_data_struct*)layer_get_data(console_layer))->layer_word_wrap        = layer_word_wrap;}
 void console_layer_set_layer_font             (Layer *console_layer, GFont          layer_font)               {((console_data_struct*)layer_get_data(console_layer))->layer_font             = layer_font;}
 
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
 void console_layer_set_background_color       (Layer *console_layer, GColor         background_color)         {((console_data_struct*)layer_get_data(console_layer))->background_color = background_color;}
 void console_layer_set_alignment              (Layer *console_layer, GTextAlignment alignment)                {((console_data_struct*)layer_get_data(console_layer))->alignment             = alignment;}
 void console_layer_set_text_color             (Layer *console_layer, GColor         text_color)               {((console_data_struct*)layer_get_data(console_layer))->text_color            = text_color;}
 void console_layer_set_word_wrap              (Layer *console_layer, int            word_wrap)                {((console_data_struct*)layer_get_data(console_layer))->word_wrap             = word_wrap;}
 void console_layer_set_font                   (Layer *console_layer, GFont          font)                     {((console_data_struct*)layer_get_data(console_layer))->font                  = font;}
+#endif
 
 void console_layer_set_dirty_automatically    (Layer *console_layer, bool           dirty_layer_automatically){((console_data_struct*)layer_get_data(console_layer))->dirty_layer_automatically = dirty_layer_automatically;}
+void console_layer_set_max_fps                (Layer *console_layer, uint8_t        max_fps)                  {((console_data_struct*)layer_get_data(console_layer))->max_fps = max_fps;}
+void console_layer_set_incremental_redraw     (Layer *console_layer, bool           incremental_redraw)       {((console_data_struct*)layer_get_data(console_layer))->incremental_redraw        = incremental_redraw;
+                                                                                                               ((console_data_struct*)layer_get_data(console_layer))->redraw_full               = true;}
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+void console_layer_set_compact_text           (Layer *console_layer, bool           compact_text)             {((console_data_struct*)layer_get_data(console_layer))->compact_text = compact_text;}
+#endif
+#ifndef CONSOLE_LAYER_NO_REPEATS
+void console_layer_set_collapse_repeats       (Layer *console_layer, bool           collapse_repeats)         {((console_data_struct*)layer_get_data(console_layer))->collapse_repeats = collapse_repeats;}
+#endif
+#ifndef CONSOLE_LAYER_NO_LEVELS
+void console_layer_set_level                  (Layer *console_layer, ConsoleLayerLevel level)                 {((console_data_struct*)layer_get_data(console_layer))->level            = level & (LEVEL_BITS >> LEVEL_SHIFT);}
+void console_layer_set_keep_level             (Layer *console_layer, ConsoleLayerLevel keep_level)            {((console_data_struct*)layer_get_data(console_layer))->keep_level       = keep_level;}
+void console_layer_set_view_level             (Layer *console_layer, ConsoleLayerLevel view_level)            {((console_data_struct*)layer_get_data(console_layer))->view_level       = view_level;
+                                                                                                               ((console_data_struct*)layer_get_data(console_layer))->redraw_full      = true;}
+#endif
 
 // ------------------------------------------------------------------------------------------------------------ //
 
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
 void console_layer_set_text_style (Layer         *console_layer,
                                    GColor         text_color,
                                    GColor         background_color,
@@ -171,8 +568,9 @@ void console_layer_set_text_style (Layer         *console_layer,
   console_data->word_wrap        = word_wrap;
   console_data->alignment        = alignment;
   
-  if(console_data->dirty_layer_automatically) layer_mark_dirty(console_layer);
+  console_layer_mark_dirty(console_layer);
 }
+#endif
 
 // ------------------------------------------------------------------------------------------------------------ //
 
@@ -191,22 +589,25 @@ void console_layer_set_layer_style (Layer         *console_layer,
   console_data->layer_alignment           = layer_alignment;
   console_data->dirty_layer_automatically = dirty_layer_automatically;
   
-  if(dirty_layer_automatically) layer_mark_dirty(console_layer);
+  console_layer_mark_dirty(console_layer);
 }
 
 // ------------------------------------------------------------------------------------------------------------ //
 
+#ifndef CONSOLE_LAYER_NO_BORDER
 void console_layer_set_border_style(Layer *console_layer, bool border_enabled, GColor border_color, int border_thickness) {
   console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
   console_data->border_color     = border_color;
   console_data->border_thickness = border_thickness;
   console_data->border_enabled   = border_enabled;
   
-  if(console_data->dirty_layer_automatically) layer_mark_dirty(console_layer);
+  console_layer_mark_dirty(console_layer);
 }
+#endif
 
 // ------------------------------------------------------------------------------------------------------------ //
 
+#ifndef CONSOLE_LAYER_NO_HEADER
 void console_layer_set_header_style(Layer         *console_layer,
                                     bool           header_enabled,
                                     GColor         header_text_color,
@@ -220,8 +621,9 @@ void console_layer_set_header_style(Layer         *console_layer,
   console_data->header_text_alignment   = header_text_alignment;
   console_data->header_enabled          = header_enabled;
 
-  if(console_data->dirty_layer_automatically) layer_mark_dirty(console_layer);
+  console_layer_mark_dirty(console_layer);
 }
+#endif
 
 // ------------------------------------------------------------------------------------------------------------ //
 
@@ -233,373 +635,3267 @@ void console_layer_set_header_style(Layer         *console_layer,
 
 
 // ------------------------------------------------------------------------------------------------------------ //
-// Write Layer
+// Chunk Index
 // ------------------------------------------------------------------------------------------------------------ //
-
-void console_layer_clear(Layer *console_layer) {
-  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
-  console_data->pos = 0;
-  console_data->buffer[0] = 0;
-  console_data->buffer[1] = 0;
-  //console_data->buffer[console_data->buffer_size - 1] = 0;
-
-  console_data->background_color = GColorInherit;
-  console_data->text_color       = GColorInherit;
-  console_data->font             = GFontInherit;
-  console_data->alignment        = GTextAlignmentInherit;
-  console_data->word_wrap        = WordWrapInherit;
-
-  if(console_data->dirty_layer_automatically)
-    layer_mark_dirty(console_layer);
+// n = 0 is the oldest chunk, n = chunk_count - 1 is the newest
+static console_chunk* console_layer_get_chunk(console_data_struct *console_data, uint16_t n) {
+  return &console_data->chunks[(console_data->chunk_first + n) % console_data->chunk_capacity];
 }
 
-// ------------------------------------------------------------------------------------------------------------ //
-
-void console_layer_write_text_and_image_styled(Layer *console_layer, GBitmap *image, char *text, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap, bool advance) {
-  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+// Sequence number of chunk n.  Chunks written one after another follow on from each other, but dropping one from behind
+// kept chunks leaves a gap (see console_layer_evict_unkept_chunk), so with levels each chunk has its own.
+static uint32_t console_layer_get_chunk_seq(console_data_struct *console_data, uint16_t n) {
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  return console_layer_get_chunk(console_data, n)->seq;
+#else
+  return console_data->chunk_seq - console_data->chunk_count + n;
+#endif
+}
 
-  console_data->pos += ((UINTPTR_MAX - (UINTPTR_MAX % console_data->buffer_size)) - console_data->buffer_size);
+// Sequence number of the oldest chunk (chunk_seq if there isn't one)
+static uint32_t console_layer_get_oldest_seq(console_data_struct *console_data) {
+  return console_data->chunk_count>0 ? console_layer_get_chunk_seq(console_data, 0) : console_data->chunk_seq;
+}
 
-  // Copy text (forwards in memory, but from last char to first char) to buffer
-  char *begin, *end;
-  while(*text || image) {
-    uint8_t settings = 0;  // new settings for each row
+// Chunk with sequence number seq, or if it's gone, the oldest one newer than it (chunk_count if there isn't one)
+static uint16_t console_layer_find_chunk(console_data_struct *console_data, uint32_t seq) {
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  uint16_t low = 0, high = console_data->chunk_count;
+  while(low < high) {
+    uint16_t middle = low + (high - low) / 2;
+    if(console_layer_get_chunk_seq(console_data, middle) < seq)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return low;
+#else
+  uint32_t oldest_seq = console_data->chunk_seq - console_data->chunk_count;
+  return seq < oldest_seq ? 0 : seq >= console_data->chunk_seq ? console_data->chunk_count : seq - oldest_seq;
+#endif
+}
 
-    
-    
-    // Adding feature: Draw text on top of image
-    begin = text;
-    if(image) {
-      settings = IMAGE_BIT;
-      while(*text) text++;   // ends on 0
-    } else {
-      while((*text) && ((*text)!=10)) text++;   // ends on 0 or 10 (newline)
-    }
-    end = text;
-    
-    
-    // write 0 no matter if 10 or 0
-    //TODO: This part should be redone
-    console_data->buffer[console_data->pos-- % console_data->buffer_size] = 0;
-    if(*text==10) {
-      console_data->buffer[console_data->pos-- % console_data->buffer_size] = 10;
-      text++; // skip past 10
-    } else if (advance) {
-      console_data->buffer[console_data->pos-- % console_data->buffer_size] = 10;
-    }
-    
-    // Copy string to buffer (forwards in memory) from end to beginning
-    while(end!=begin)
-      console_data->buffer[console_data->pos-- % console_data->buffer_size] = *(--end);
-    
-    
-    
-    // Copy Image Location to buffer
-    if(image) {
-      for (uintptr_t i=0; i<sizeof(image); i++) {
-      console_data->buffer[console_data->pos-- % console_data->buffer_size] = ((uint8_t*)&image)[i];
-      }
-    }
-    image = NULL;  // to exit the while loop above
+// A chunk's style byte (0 if chunks don't have one)
+static uint8_t console_layer_get_style_byte(console_data_struct *console_data, console_chunk *chunk) {
+  return STYLE_BYTE_LENGTH ? console_data->buffer[chunk->offset] : 0;
+}
 
+// Length of the header at the start of a chunk, from its style byte
+static size_t console_layer_get_header_length(uint8_t style_byte) {
+  return STYLE_BYTE_LENGTH + (HAS_IMAGE(style_byte)?sizeof(GBitmap*):0);
+}
 
+// Whether chunk n's text ends in a newline, so the chunk after it starts a new row
+static bool console_layer_chunk_ends_row(console_data_struct *console_data, uint16_t n) {
+  console_chunk *chunk = console_layer_get_chunk(console_data, n);
+  return chunk->length - 1 > console_layer_get_header_length(console_layer_get_style_byte(console_data, chunk)) &&
+         console_data->buffer[(chunk->offset + chunk->length - 2) % console_data->buffer_size]==10;
+}
 
-    
-    // Copy header information
-    if(font) {
-      for (uintptr_t i=0; i<sizeof(font); i++)
-        console_data->buffer[console_data->pos-- % console_data->buffer_size] = ((uint8_t*)&font)[i];
-      settings |= FONT_BIT;
-    }
+// First chunk of the row chunk n is on
+static uint16_t console_layer_get_row_start(console_data_struct *console_data, uint16_t n) {
+  while(n>0 && !console_layer_chunk_ends_row(console_data, n - 1)) n--;
+  return n;
+}
 
-    if(text_color.argb) {
-      console_data->buffer[console_data->pos-- % console_data->buffer_size] = text_color.argb;
-      settings |= TEXT_COLOR_BIT;
-    }
+// Whether anything on the row chunk n ends is drawn (see console_layer_set_view_level)
+static bool console_layer_row_shown(console_data_struct *console_data, uint16_t n) {
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  for(uint16_t first = console_layer_get_row_start(console_data, n); ; n--) {
+    if(GET_LEVEL(console_layer_get_style_byte(console_data, console_layer_get_chunk(console_data, n))) >= console_data->view_level)
+      return true;
+    if(n==first)
+      return false;
+  }
+#endif
+  return true;
+}
 
-    if(background_color.argb) {
-      console_data->buffer[console_data->pos-- % console_data->buffer_size] = background_color.argb;
-      settings |= BACKGROUND_COLOR_BIT;
-    }
+// Chunks [0, view end) are drawn: all of them when following the tail, otherwise up to the one anchoring the bottom row
+// (or the one before it, if that's been evicted from behind kept chunks, or the oldest if everything up to it has).
+// Scrolling back with nothing written leaves scroll_seq at "chunk -1", which comes out past the newest.
+static uint16_t console_layer_get_view_end(console_data_struct *console_data) {
+  if(console_data->follow_tail || console_data->chunk_count==0 || console_data->scroll_seq >= console_data->chunk_seq)
+    return console_data->chunk_count;
+  uint16_t n = console_layer_find_chunk(console_data, console_data->scroll_seq);
+  return n==0 || console_layer_get_chunk_seq(console_data, n) == console_data->scroll_seq ? n + 1 : n;
+}
 
-    settings |= (word_wrap&WORD_WRAP_BITS);
-    settings |= (alignment==GTextAlignmentLeft?0b0000 : alignment==GTextAlignmentCenter?0b0100 : alignment==GTextAlignmentRight?0b1000 : 0b1100);
+// Drops the oldest chunk
+static void console_layer_evict_chunk(console_data_struct *console_data) {
+  COUNT_STAT(console_data, chunks_evicted, 1);
+  console_data->buffer_used -= console_data->chunks[console_data->chunk_first].length;
+  console_data->chunk_first  = (console_data->chunk_first + 1) % console_data->chunk_capacity;
+  console_data->chunk_count--;
+}
 
-    console_data->buffer[console_data->pos-- % console_data->buffer_size] = settings; // Save settings
-    console_data->buffer[console_data->pos % console_data->buffer_size] = 0;          // EOF -- Head/Tail buffer transition point
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+static void console_layer_forget_cached_rows(console_data_struct *console_data, uint32_t seq);
+#endif
+
+#ifndef CONSOLE_LAYER_NO_LEVELS
+#ifndef CONSOLE_LAYER_MAX_KEPT_PERCENT
+#define CONSOLE_LAYER_MAX_KEPT_PERCENT 50  // Most of the buffer that chunks at the keep level can hold on to
+#endif
+
+static void console_layer_persist_touch_chunk(console_data_struct *console_data, console_chunk *chunk, size_t index, size_t length);
+
+// Drops the oldest chunk below the keep level instead of the oldest chunk, if every chunk older than it is at the keep
+// level or above and they fit in CONSOLE_LAYER_MAX_KEPT_PERCENT of the buffer: they're moved up over it, so the chunks
+// still follow on from each other.  Returns false if it didn't drop one.
+static bool console_layer_evict_unkept_chunk(console_data_struct *console_data) {
+  if(console_data->keep_level == ConsoleLayerLevelDebug)
+    return false;  // Everything's kept, so nothing is
+  size_t kept = 0, max_kept = console_data->buffer_size * CONSOLE_LAYER_MAX_KEPT_PERCENT / 100;
+  uint16_t k = 0;
+  for(; k < console_data->chunk_count; k++) {
+    console_chunk *chunk = console_layer_get_chunk(console_data, k);
+    if(GET_LEVEL(console_layer_get_style_byte(console_data, chunk)) < console_data->keep_level)
+      break;
+    kept += chunk->length;
+    if(kept > max_kept)
+      return false;
+  }
+  if(k==0 || k==console_data->chunk_count)
+    return false;
+
+  // Copy the kept bytes up so they end where chunk k did, last piece first, in pieces that don't cross the end of the buffer
+  uint32_t seq  = console_layer_get_chunk_seq(console_data, k);
+  size_t length = console_layer_get_chunk(console_data, k)->length;
+  size_t from   = console_layer_get_chunk(console_data, k)->offset;
+  size_t to     = (from + length) % console_data->buffer_size;
+  while(kept > 0) {
+    if(from==0) from = console_data->buffer_size;
+    if(to==0)   to   = console_data->buffer_size;
+    size_t piece = kept < from ? kept : from;
+    if(piece > to) piece = to;
+    from -= piece;
+    to   -= piece;
+    kept -= piece;
+    memmove(&console_data->buffer[to], &console_data->buffer[from], piece);
+  }
+  for(uint16_t n=k; n>0; n--) {
+    console_chunk *chunk = console_layer_get_chunk(console_data, n);
+    *chunk = *console_layer_get_chunk(console_data, n - 1);
+    chunk->offset = (chunk->offset + length) % console_data->buffer_size;
+    console_layer_persist_touch_chunk(console_data, chunk, chunk->offset, chunk->length);
   }
 
-  console_data->pos %= console_data->buffer_size;
-
-  if(console_data->dirty_layer_automatically)
-    layer_mark_dirty(console_layer);
+  if(seq >= console_data->drawn_oldest_seq)  // It was on screen
+    console_data->redraw_full = true;
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+  console_layer_forget_cached_rows(console_data, seq);  // Its row (and, to keep it simple, every older one)
+#endif
+  COUNT_STAT(console_data, chunks_evicted, 1);
+  console_data->buffer_used -= length;
+  console_data->chunk_first  = (console_data->chunk_first + 1) % console_data->chunk_capacity;
+  console_data->chunk_count--;
+  return true;
+}
+#endif
+
+// Evicts whole chunks, oldest first (or the oldest below the keep level), until a chunk_length byte chunk fits in both
+// the buffer and the index
+static void console_layer_make_room(console_data_struct *console_data, size_t chunk_length) {
+  while(console_data->chunk_count>0 && (console_data->buffer_used + chunk_length > console_data->buffer_size || console_data->chunk_count == console_data->chunk_capacity))
+#ifndef CONSOLE_LAYER_NO_LEVELS
+    if(!console_layer_evict_unkept_chunk(console_data))
+#endif
+      console_layer_evict_chunk(console_data);
 }
 
 // ------------------------------------------------------------------------------------------------------------ //
-
-void console_layer_write_text_and_image(Layer *console_layer, GBitmap *image, char *text) {
-  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
-  console_layer_write_text_and_image_styled(console_layer, image, text, console_data->text_color, console_data->background_color, console_data->font, console_data->alignment, console_data->word_wrap, false);
+// Persistence
+// ------------------------------------------------------------------------------------------------------------ //
+// The chunk index and the buffer sit next to each other in memory, so they're mirrored together as one region, cut
+// into PERSIST_DATA_MAX_LENGTH byte blocks with a key each.  Writes mark the blocks they touch, and a timer saves just
+// those a little later (console_layer_destroy saves whatever's left).  The style table gets keys of its own, and the
+// first key holds the positions and counts, saved last so it never points at text that isn't saved yet.
+//   Keys: first_key = console_persist_meta, then the style table, then the index and buffer
+#ifndef CONSOLE_LAYER_PERSIST_FLUSH_MS
+#define CONSOLE_LAYER_PERSIST_FLUSH_MS 2000  // How long after a write the dirty blocks are saved
+#endif
+#define PERSIST_VERSION 3
+
+#ifdef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  #define PERSIST_STYLES_SIZE 0
+#else
+  #define PERSIST_STYLES_SIZE sizeof(((console_data_struct*)0)->styles)
+#endif
+#define PERSIST_BLOCKS(size) (((size) + PERSIST_DATA_MAX_LENGTH - 1) / PERSIST_DATA_MAX_LENGTH)
+
+typedef struct console_persist_meta {
+  uint8_t            version;           // Saved by a build that lays the bytes out the same way?
+  uint8_t            chunk_size;
+  uint8_t            header_length;
+  uint16_t           styles_size;
+  uint16_t           buffer_size;       // Same size layer?
+  uint16_t           chunk_capacity;
+  uint16_t           pos;
+  uint16_t           buffer_used;
+  uint16_t           chunk_first;
+  uint16_t           chunk_count;
+  uint8_t            style_count;
+  uint32_t           chunk_seq;
+} console_persist_meta;
+
+static console_persist_meta console_layer_persist_get_meta(console_data_struct *console_data) {
+  console_persist_meta meta;
+  memset(&meta, 0, sizeof(meta));  // Padding's saved and compared too
+  meta.version        = PERSIST_VERSION;
+  meta.chunk_size     = sizeof(console_chunk);
+  meta.header_length  = MAX_HEADER_LENGTH;
+  meta.styles_size    = PERSIST_STYLES_SIZE;
+  meta.buffer_size    = console_data->buffer_size;
+  meta.chunk_capacity = console_data->chunk_capacity;
+  meta.pos            = console_data->pos;
+  meta.buffer_used    = console_data->buffer_used;
+  meta.chunk_first    = console_data->chunk_first;
+  meta.chunk_count    = console_data->chunk_count;
+  meta.chunk_seq      = console_data->chunk_seq;
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  meta.style_count    = console_data->style_count;
+#endif
+  return meta;
 }
 
-// ------------------------------------------------------------------------------------------------------------ //
+static size_t console_layer_persist_region_size(console_data_struct *console_data) {
+  return console_data->chunk_capacity * sizeof(console_chunk) + console_data->buffer_size;
+}
 
-void console_layer_writeln_text_and_image(Layer *console_layer, GBitmap *image, char *text) {
-  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
-  console_layer_write_text_and_image_styled(console_layer, image, text, console_data->text_color, console_data->background_color, console_data->font, console_data->alignment, console_data->word_wrap, true);
+static uint32_t console_layer_persist_region_key(console_data_struct *console_data) {
+  return console_data->persist_key + 1 + PERSIST_BLOCKS(PERSIST_STYLES_SIZE);
 }
 
-// ------------------------------------------------------------------------------------------------------------ //
+// Saves or loads block number block of size bytes at data
+static bool console_layer_persist_write_block(uint32_t key, void *data, size_t size, size_t block) {
+  size_t offset = block * PERSIST_DATA_MAX_LENGTH;
+  size_t length = size - offset < PERSIST_DATA_MAX_LENGTH ? size - offset : PERSIST_DATA_MAX_LENGTH;
+  return persist_write_data(key + block, (uint8_t*)data + offset, length) == (int)length;
+}
 
-void console_layer_write_text_styled(Layer *console_layer, char *text, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap, bool advance) {
-  console_layer_write_text_and_image_styled(console_layer, NULL_IMAGE, text, text_color, background_color, font, alignment, word_wrap, advance);
+static bool console_layer_persist_read_block(uint32_t key, void *data, size_t size, size_t block) {
+  size_t offset = block * PERSIST_DATA_MAX_LENGTH;
+  size_t length = size - offset < PERSIST_DATA_MAX_LENGTH ? size - offset : PERSIST_DATA_MAX_LENGTH;
+  return persist_read_data(key + block, (uint8_t*)data + offset, length) == (int)length;
 }
 
-// ------------------------------------------------------------------------------------------------------------ //
+// Saves the dirty blocks, then the meta.  If persistent storage is full, what's left stays dirty for next time.
+static void console_layer_persist_write(console_data_struct *console_data) {
+  if(!console_data->persist_dirty)
+    return;
+  if(console_data->persist_timer) {
+    app_timer_cancel(console_data->persist_timer);
+    console_data->persist_timer = NULL;
+  }
 
-void console_layer_write_image_styled(Layer *console_layer, GBitmap *image, GColor background_color, GTextAlignment alignment, bool advance) {
-  if(image)
-    console_layer_write_text_and_image_styled(console_layer, image, " ", GColorInherit, background_color, GFontInherit, alignment, WordWrapFalse, advance);
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  if(console_data->persist_styles_dirty) {
+    for(size_t block=0; block<PERSIST_BLOCKS(PERSIST_STYLES_SIZE); block++)
+      if(!console_layer_persist_write_block(console_data->persist_key + 1, console_data->styles, PERSIST_STYLES_SIZE, block))
+        return;
+    console_data->persist_styles_dirty = false;
+  }
+#endif
+
+  size_t region_size = console_layer_persist_region_size(console_data);
+  for(size_t block=0; block<PERSIST_BLOCKS(region_size); block++)
+    if(console_data->persist_dirty[block / 8] & (1 << (block % 8))) {
+      if(!console_layer_persist_write_block(console_layer_persist_region_key(console_data), console_data->chunks, region_size, block))
+        return;
+      console_data->persist_dirty[block / 8] &= ~(1 << (block % 8));
+    }
+
+  console_persist_meta meta = console_layer_persist_get_meta(console_data);
+  persist_write_data(console_data->persist_key, &meta, sizeof(meta));
 }
 
-// ------------------------------------------------------------------------------------------------------------ //
+static void console_layer_persist_timer_callback(void *data) {
+  console_data_struct *console_data = (console_data_struct*)data;
+  console_data->persist_timer = NULL;
+  console_layer_persist_write(console_data);
+}
 
-void console_layer_write_text(Layer *console_layer, char *text) {
-  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
-  console_layer_write_text_and_image_styled(console_layer, NULL_IMAGE, text, console_data->text_color, console_data->background_color, console_data->font, console_data->alignment, console_data->word_wrap, false);
+// Saves the meta (and anything dirty) a little later, so a run of writes is saved together
+static void console_layer_persist_schedule(console_data_struct *console_data) {
+  if(console_data->persist_dirty && !console_data->persist_timer)
+    console_data->persist_timer = app_timer_register(CONSOLE_LAYER_PERSIST_FLUSH_MS, console_layer_persist_timer_callback, console_data);
 }
 
-// ------------------------------------------------------------------------------------------------------------ //
+// Marks length (> 0) bytes of the region, from byte start on, as needing saving
+static void console_layer_persist_touch(console_data_struct *console_data, size_t start, size_t length) {
+  if(!console_data->persist_dirty)
+    return;
+  for(size_t block = start / PERSIST_DATA_MAX_LENGTH; block <= (start + length - 1) / PERSIST_DATA_MAX_LENGTH; block++)
+    console_data->persist_dirty[block / 8] |= 1 << (block % 8);
+  console_layer_persist_schedule(console_data);
+}
 
-void console_layer_writeln_text(Layer *console_layer, char *text) {
-  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
-  console_layer_write_text_and_image_styled(console_layer, NULL_IMAGE, text, console_data->text_color, console_data->background_color, console_data->font, console_data->alignment, console_data->word_wrap, true);
+// Marks a chunk's index entry and its length bytes of the buffer (which may wrap around the end of the buffer)
+static void console_layer_persist_touch_chunk(console_data_struct *console_data, console_chunk *chunk, size_t index, size_t length) {
+  size_t buffer_start = console_data->chunk_capacity * sizeof(console_chunk);
+  size_t first_part   = console_data->buffer_size - index;
+  console_layer_persist_touch(console_data, (chunk - console_data->chunks) * sizeof(console_chunk), sizeof(console_chunk));
+  console_layer_persist_touch(console_data, buffer_start + index, length <= first_part ? length : first_part);
+  if(length > first_part)
+    console_layer_persist_touch(console_data, buffer_start, length - first_part);
 }
 
-// ------------------------------------------------------------------------------------------------------------ //
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+static void console_layer_persist_touch_styles(console_data_struct *console_data) {
+  console_data->persist_styles_dirty = true;
+  console_layer_persist_schedule(console_data);
+}
+#endif
 
-void console_layer_write_image(Layer *console_layer, GBitmap *image) {
+// Loads what was saved straight back into the index and buffer, after checking it was saved by a layer just like this
+// one and still makes sense (it's thrown out if the app was stopped between saving the blocks and the meta).
+// Pointers don't survive the app closing, so images are dropped and fonts fall back to the layer's.
+static bool console_layer_persist_read(Layer *console_layer) {
   console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
-  console_layer_write_image_styled(console_layer, image, console_data->background_color, console_data->alignment, false);
+  console_persist_meta meta, expected = console_layer_persist_get_meta(console_data);
+  if(persist_read_data(console_data->persist_key, &meta, sizeof(meta)) != sizeof(meta)               ||
+     memcmp(&meta, &expected, offsetof(console_persist_meta, pos))                                  ||
+     meta.pos >= meta.buffer_size || meta.buffer_used > meta.buffer_size                           ||
+     meta.chunk_first >= meta.chunk_capacity || meta.chunk_count > meta.chunk_capacity)
+    return false;
+
+  size_t region_size = console_layer_persist_region_size(console_data);
+  for(size_t block=0; block<PERSIST_BLOCKS(region_size); block++)
+    if(!console_layer_persist_read_block(console_layer_persist_region_key(console_data), console_data->chunks, region_size, block))
+      goto fail;
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  if(meta.style_count > CONSOLE_LAYER_MAX_STYLES)
+    goto fail;
+  for(size_t block=0; block<PERSIST_BLOCKS(PERSIST_STYLES_SIZE); block++)
+    if(!console_layer_persist_read_block(console_data->persist_key + 1, console_data->styles, PERSIST_STYLES_SIZE, block))
+      goto fail;
+  console_data->style_count = meta.style_count;
+  for(uint8_t i=0; i<console_data->style_count; i++)
+    console_data->styles[i].font = GFontInherit;
+#endif
+  console_data->pos         = meta.pos;
+  console_data->buffer_used = meta.buffer_used;
+  console_data->chunk_first = meta.chunk_first;
+  console_data->chunk_count = meta.chunk_count;
+  console_data->chunk_seq   = meta.chunk_seq;
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+  console_layer_forget_cached_rows(console_data, UINT32_MAX);  // (sequence numbers can go back)
+#endif
+
+  // Chunks have to follow on from each other up to pos (with sequence numbers going up to chunk_seq), be in a style
+  // that's in the table and end in a 0
+  size_t used = 0;
+  for(uint16_t n=0; n<console_data->chunk_count; n++) {
+    console_chunk *chunk = console_layer_get_chunk(console_data, n);
+    size_t next = n+1<console_data->chunk_count ? console_layer_get_chunk(console_data, n+1)->offset : console_data->pos;
+    if(chunk->offset >= console_data->buffer_size || chunk->length > console_data->buffer_size ||
+       (chunk->offset + chunk->length) % console_data->buffer_size != next)
+      goto fail;
+#ifndef CONSOLE_LAYER_NO_LEVELS
+    if(chunk->seq >= (n+1<console_data->chunk_count ? console_layer_get_chunk(console_data, n+1)->seq : console_data->chunk_seq))
+      goto fail;
+#endif
+    uint8_t style_byte = console_layer_get_style_byte(console_data, chunk);
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+    if((style_byte&STYLE_ID_BITS) >= console_data->style_count)
+      goto fail;
+#endif
+#ifdef CONSOLE_LAYER_NO_COMPACT_TEXT
+    if(STYLE_BYTE_LENGTH && (style_byte&COMPACT_BIT))  // Packed by a build that could unpack it
+      goto fail;
+#endif
+    size_t header_length = console_layer_get_header_length(style_byte);
+    if(chunk->length <= header_length || console_data->buffer[(chunk->offset + chunk->length - 1) % console_data->buffer_size]!=0)
+      goto fail;
+    for(size_t i=STYLE_BYTE_LENGTH; i<header_length; i++)  // No image
+      console_data->buffer[(chunk->offset + i) % console_data->buffer_size] = 0;
+    chunk->height = LAYOUT_UNMEASURED;
+    FORGET_ROUND_LAYOUT(chunk);
+    used += chunk->length;
+  }
+  if(used != console_data->buffer_used)
+    goto fail;
+
+  console_data->follow_tail = true;
+  console_data->redraw_full = true;
+  console_layer_mark_dirty(console_layer);
+  return true;
+
+fail:
+  console_layer_clear(console_layer);
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  console_data->style_count = 0;
+#endif
+  return false;
 }
 
 // ------------------------------------------------------------------------------------------------------------ //
 
-void console_layer_writeln_image(Layer *console_layer, GBitmap *image) {
+bool console_layer_enable_persistence(Layer *console_layer, uint32_t first_key) {
   console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
-  console_layer_write_image_styled(console_layer, image, console_data->background_color, console_data->alignment, true);
+  if(console_data->persist_dirty)  // Already on
+    return false;
+  size_t bitmap_size = (PERSIST_BLOCKS(console_layer_persist_region_size(console_data)) + 7) / 8;
+  if(!(console_data->persist_dirty = malloc(bitmap_size)))
+    return false;
+  console_data->persist_key = first_key;
+
+  // If there's nothing to restore, everything's saved the first time round, over whatever was there
+  bool restored = console_layer_persist_read(console_layer);
+  memset(console_data->persist_dirty, restored ? 0 : 0xFF, bitmap_size);
+  console_data->persist_styles_dirty = !restored;
+  return restored;
 }
 
-// ------------------------------------------------------------------------------------------------------------ //
-
-
-
-
+void console_layer_persist_flush(Layer *console_layer) {
+  console_layer_persist_write((console_data_struct*)layer_get_data(console_layer));
+}
 
 // ------------------------------------------------------------------------------------------------------------ //
-// Draw Layer
+// Storage
 // ------------------------------------------------------------------------------------------------------------ //
-static void console_layer_update(Layer *console_layer, GContext *ctx) {
-  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
-  GRect bounds = layer_get_bounds(console_layer);
-  graphics_context_set_stroke_width(ctx, 1);
-
-  // Layer Background
-  if(console_data->layer_background_color.argb!=GColorClear.argb) {
-    graphics_context_set_fill_color(ctx, console_data->layer_background_color);
-    graphics_fill_rect(ctx, (GRect){.origin = GPoint(0, 0), .size = bounds.size}, 0, GCornerNone);
-  }
-
-  // If there's a border, inset the layer's contents
-  if(console_data->border_enabled && console_data->border_thickness>0)
-    bounds = grect_inset(bounds, GEdgeInsets(console_data->border_thickness));
-
-  // Set internal margin for the layer (TODO: Maybe add this as an external setting?)
-  int margin_top_bottom = 0;
-  int margin_left_right = 1;
-  GRect margin_bounds = grect_inset(bounds, GEdgeInsets(margin_top_bottom, margin_left_right));
-
-  // Display Rows
-  int16_t y = margin_bounds.size.h; // Start at the bottom
-  int16_t row_height = 0;    // row_height = tallest font on the row
-   
-  // Get past the EOF 0
-  intptr_t cursor = console_data->pos + 1;
-  
-  // Make advance=true so if bounds.size.h==0 it will just quit
-  bool advance = true;
-
-  // adding "|| !advance" so all text in multiple-text-segments-on-one-row which are half cutoff by the top border are all displayed
-  while ((y>margin_bounds.origin.y || !advance) && console_data->buffer[cursor % console_data->buffer_size]) {  // While text is within visible bounds && not at EOF
-    advance = false;
-    
-    // First thing is the Settings
-    uint8_t settings = console_data->buffer[cursor % console_data->buffer_size];
-    
-    bool word_wrap = settings&WORD_WRAP_INHERIT_BIT ? console_data->layer_word_wrap : settings&WORD_WRAP_BIT;
+// A layer's chunk index and buffer sit one after the other, either just after its data or in a shared pool, and can be
+// moved and resized.  Resizing lines the chunks up from the start of the buffer (rotating it in place, so nothing
+// needs a second buffer), then only what's in use has to be moved.
 
-    // This could be quicker if I could just assume the enum: GTextAlignmentLeft=0, Center=1 and Right=2 (which it does.)  But I can't cause it'd lose abstraction.
-    GTextAlignment alignment;
-    switch (settings & ALIGNMENT_BITS) {
-      case 0b0000: alignment = GTextAlignmentLeft;   break;
-      case 0b0100: alignment = GTextAlignmentCenter; break;
-      case 0b1000: alignment = GTextAlignmentRight;  break;
-      default:     alignment = console_data->layer_alignment;
-    }
+// Bytes the index and buffer for a buffer_size byte buffer take
+static size_t console_layer_storage_size(size_t buffer_size) {
+  return (buffer_size / INDEX_BYTES_PER_CHUNK + 1) * sizeof(console_chunk) + buffer_size;
+}
 
-    GColor background_color = console_data->layer_background_color;  // Assume inherit from layer
-    if (settings&BACKGROUND_COLOR_BIT)
-      background_color = (GColor){.argb=console_data->buffer[++cursor % console_data->buffer_size]};
+// Points the layer at the index and buffer_size byte buffer at storage
+static void console_layer_set_storage(console_data_struct *console_data, uint8_t *storage, size_t buffer_size) {
+  console_data->chunk_capacity = buffer_size / INDEX_BYTES_PER_CHUNK + 1;
+  console_data->chunks         = (console_chunk*)storage;
+  console_data->buffer         = (char*)(console_data->chunks + console_data->chunk_capacity);
+  console_data->buffer_size    = buffer_size;
+}
 
-    GColor text_color = console_data->layer_text_color;  // Assume inherit from layer
-    if (settings&TEXT_COLOR_BIT)
-      text_color = (GColor){.argb=console_data->buffer[++cursor % console_data->buffer_size]};
-    graphics_context_set_text_color(ctx, text_color.argb ? text_color : console_data->layer_text_color);
+static void console_layer_reverse(uint8_t *array, size_t count, size_t element_size) {
+  uint8_t swap[sizeof(console_chunk)];
+  for(uint8_t *a = array, *b = array + (count - 1) * element_size; count>1 && a<b; a += element_size, b -= element_size) {
+    memcpy(swap, a, element_size);
+    memcpy(a, b, element_size);
+    memcpy(b, swap, element_size);
+  }
+}
 
-    GFont font = console_data->layer_font;  // Assume inherit from layer
-    if (settings&FONT_BIT)
-      for (uintptr_t i=0; i<sizeof(GFont); i++) {
-      ((uint8_t*)&font)[(sizeof(GFont)-1)-i] = console_data->buffer[++cursor % console_data->buffer_size];
-    }
+// Rotates an array of count elements left by k, in place
+static void console_layer_rotate(void *array, size_t count, size_t element_size, size_t k) {
+  if(k==0) return;
+  console_layer_reverse(array, k, element_size);
+  console_layer_reverse((uint8_t*)array + k * element_size, count - k, element_size);
+  console_layer_reverse(array, count, element_size);
+}
 
-    GRect rect = GRectZero;
-    GBitmap *image = NULL;
-    if(settings&IMAGE_BIT) {
-      // Read image
-      for (uintptr_t i=0; i<sizeof(image); i++)
-        ((uint8_t*)&image)[(sizeof(image)-1)-i] = console_data->buffer[++cursor % console_data->buffer_size];
-      rect.size = gbitmap_get_bounds(image).size;
-      switch (alignment) {
-        case GTextAlignmentCenter: rect.origin.x = (margin_bounds.size.w - rect.size.w) / 2; break;
-        case GTextAlignmentRight:  rect.origin.x = (margin_bounds.size.w - rect.size.w)    ; break;
-        default: break;
-      }
+// Moves the index and buffer to storage, which can overlap where they are now, with a buffer_size byte buffer.  The
+// oldest chunks are evicted if they don't all fit.
+static void console_layer_relocate(console_data_struct *console_data, uint8_t *storage, size_t buffer_size) {
+  uint8_t *old_storage = (uint8_t*)console_data->chunks;
+  if(buffer_size == console_data->buffer_size) {  // Just moving
+    if(storage != old_storage) {
+      memmove(storage, old_storage, console_layer_storage_size(buffer_size));
+      console_layer_set_storage(console_data, storage, buffer_size);
     }
+    return;
+  }
 
-    // Copy the 0-terminated string into a temp buffer (because pebble's text functions can't wrap around end of buffer)
-    //char text[console_data->buffer_size + 1];         // allocate on stack (Locks up when using DictationAPI)
-    char *text = malloc(console_data->buffer_size + 1); // allocate on heap
-    if(text) {
-      intptr_t i = -1;
-      do {
-        if (i < (intptr_t)(console_data->buffer_size)) i++;     // Stop it from maxing out
-        text[i] = console_data->buffer[++cursor % console_data->buffer_size];
-        if(text[i]==10) advance = true;  // If there ever is a 10 (newline), advance
-      } while (text[i]);
-      //end text
-
-      // If we've not gone beyond the size of the buffer, then the data should be valid
-      // If we HAVE gone beyond the buffer_size, buffer[cursor%size] is pointing at 0, exiting the while loop
-      if(cursor - console_data->pos < console_data->buffer_size) {
-        cursor++;  // Get past the string terminating 0 so the while can loop (unless we're now at the EOF 0)
-
-        // Advance or not -- advance means moving text drawing to the next row up
-        if (advance) {
-          y -= row_height;
-          row_height = 0;
-        }
+  uint16_t chunk_capacity = buffer_size / INDEX_BYTES_PER_CHUNK + 1;
+  while(console_data->chunk_count>0 && (console_data->buffer_used > buffer_size || console_data->chunk_count > chunk_capacity))
+    console_layer_evict_chunk(console_data);
+
+  // Line the chunks up from the start of the index and buffer
+  size_t first = console_data->chunk_count>0 ? console_data->chunks[console_data->chunk_first].offset : 0;
+  console_layer_rotate(console_data->buffer, console_data->buffer_size, 1, first);
+  console_layer_rotate(console_data->chunks, console_data->chunk_capacity, sizeof(console_chunk), console_data->chunk_first);
+  for(uint16_t n=0; n<console_data->chunk_count; n++)
+    console_data->chunks[n].offset = (console_data->chunks[n].offset + console_data->buffer_size - first) % console_data->buffer_size;
+
+  // Move them (whichever's moving towards the other goes first, so neither runs over the other before it's moved)
+  char *buffer = (char*)((console_chunk*)storage + chunk_capacity);
+  if(buffer > console_data->buffer) {
+    memmove(buffer,  console_data->buffer, console_data->buffer_used);
+    memmove(storage, old_storage,          console_data->chunk_count * sizeof(console_chunk));
+  } else {
+    memmove(storage, old_storage,          console_data->chunk_count * sizeof(console_chunk));
+    memmove(buffer,  console_data->buffer, console_data->buffer_used);
+  }
+  console_layer_set_storage(console_data, storage, buffer_size);
+  console_data->chunk_first = 0;
+  console_data->pos         = console_data->buffer_used % buffer_size;
+  console_data->redraw_full = true;
+
+  // Everything's somewhere else now, so it all has to be saved again
+  if(console_data->persist_dirty) {
+    free(console_data->persist_dirty);
+    size_t bitmap_size = (PERSIST_BLOCKS(console_layer_persist_region_size(console_data)) + 7) / 8;
+    if((console_data->persist_dirty = malloc(bitmap_size)))
+      memset(console_data->persist_dirty, 0xFF, bitmap_size);
+    console_layer_persist_schedule(console_data);
+  }
+}
 
-        // Draw the row background, if there is one
-        // Calculate row height, draw the background if it has changed
-        // object_height = height of current text to draw or height of image to draw
-        // row_height = height of tallest text drawn on same row (without advance, e.g. without writeln())
-        int16_t text_height = graphics_text_layout_get_content_size(word_wrap?text:" ", font, GRect(0, 0, margin_bounds.size.w, 0x7FFF), GTextOverflowModeTrailingEllipsis, alignment).h;
-        int16_t object_height = rect.size.h>text_height ? rect.size.h : text_height; // Height of the current image/text being drawn is the max of the two
-        if(object_height>row_height) {
-          if(background_color.argb!=GColorClear.argb) {
-            graphics_context_set_fill_color(ctx, background_color);
-            graphics_fill_rect(ctx, GRect(bounds.origin.x, bounds.origin.y + y - object_height, bounds.size.w, object_height - row_height), 0, GCornerNone);  // fill background (or horizontal sliver if difference in font height or multi-line height)
-          }
-          row_height = object_height;
-        }
+// ------------------------------------------------------------------------------------------------------------ //
+// Shared Pool
+// ------------------------------------------------------------------------------------------------------------ //
+// The layers in a pool have their index and buffer one after the other in the pool's memory (in the order of the
+// layers array).  Each starts with its minimum, and a layer that's filling up grows, up to its maximum, into free
+// space or space taken back from layers that haven't been written to for CONSOLE_LAYER_POOL_IDLE_MS.  Free space
+// is wherever layers have shrunk or been destroyed, so it's gathered up by sliding the layers around it first.
+// There's one scratch buffer for the whole pool, as big as the biggest maximum: it's only used for a moment at a time.
+#ifndef CONSOLE_LAYER_POOL_MAX_LAYERS
+#define CONSOLE_LAYER_POOL_MAX_LAYERS 4
+#endif
+#ifndef CONSOLE_LAYER_POOL_IDLE_MS
+#define CONSOLE_LAYER_POOL_IDLE_MS    5000   // A layer that hasn't been written to for this long gives space back
+#endif
+#ifndef CONSOLE_LAYER_POOL_GROW_SIZE
+#define CONSOLE_LAYER_POOL_GROW_SIZE  256    // Bytes of buffer a layer grows by at a time
+#endif
+#define POOL_ALIGN(size) ((size) & ~3)       // Buffer sizes are kept to multiples of 4, so the next layer's index is aligned
+
+struct ConsoleLayerPool {
+  uint8_t           *memory;
+  size_t             size;
+  char              *scratch;
+  size_t             scratch_size;
+  uint8_t            layer_count;
+  Layer             *layers[CONSOLE_LAYER_POOL_MAX_LAYERS];  // In the order they are in memory
+};
+
+static size_t console_layer_pool_get_free(ConsoleLayerPool *pool) {
+  size_t used = 0;
+  for(uint8_t i=0; i<pool->layer_count; i++)
+    used += console_layer_storage_size(((console_data_struct*)layer_get_data(pool->layers[i]))->buffer_size);
+  return pool->size - used;
+}
 
-        // Draw the image
-        if(settings&IMAGE_BIT && image) {
-          graphics_context_set_compositing_mode(ctx, GCompOpSet);
-          graphics_draw_bitmap_in_rect(ctx, image, GRect(margin_bounds.origin.x + rect.origin.x, margin_bounds.origin.y + y - rect.size.h, rect.size.w, rect.size.h));
-        }
-        // Render Text (y-3 because Pebble's text rendering is dumb and goes outside rect)
-          graphics_draw_text(ctx, text, font, GRect(margin_bounds.origin.x, margin_bounds.origin.y + (y-3) - text_height, margin_bounds.size.w, text_height), GTextOverflowModeTrailingEllipsis, alignment, NULL);  // align-bottom
-        //graphics_draw_text(ctx, text, font, GRect(margin_bounds.origin.x, margin_bounds.origin.y + (y-3) - row_height,  margin_bounds.size.w, row_height ), GTextOverflowModeTrailingEllipsis, alignment, NULL);  // align-top
-      } // END if data valid
-      free(text);
-    }
-  } // END While
+// Slides the layers up to and including layer i to the start of the pool, and the rest to the end, so all the free
+// space is just after layer i
+static void console_layer_pool_compact(ConsoleLayerPool *pool, int i) {
+  uint8_t *storage = pool->memory;
+  for(int j=0; j<=i; j++) {
+    console_data_struct *console_data = (console_data_struct*)layer_get_data(pool->layers[j]);
+    console_layer_relocate(console_data, storage, console_data->buffer_size);
+    storage += console_layer_storage_size(console_data->buffer_size);
+  }
+  storage = pool->memory + pool->size;
+  for(int j=pool->layer_count - 1; j>i; j--) {
+    console_data_struct *console_data = (console_data_struct*)layer_get_data(pool->layers[j]);
+    storage -= console_layer_storage_size(console_data->buffer_size);
+    console_layer_relocate(console_data, storage, console_data->buffer_size);
+  }
+}
 
-  // Draw Header (no internal margin)
-  int16_t header_height = 0;
-  if(console_data->header_enabled) {
-    header_height = graphics_text_layout_get_content_size(console_data->header_text, console_data->header_font, bounds, GTextOverflowModeTrailingEllipsis, console_data->header_text_alignment).h;
-    if(header_height>0) {
-      if(console_data->header_background_color.argb!=GColorClear.argb)
-        graphics_context_set_fill_color(ctx, console_data->header_background_color);
-      else if(console_data->layer_background_color.argb!=GColorClear.argb)
-        graphics_context_set_fill_color(ctx, console_data->layer_background_color);
-      else
-        graphics_context_set_fill_color(ctx, GColorWhite);  // The Console Layer Library currently doesn't support clear headers due to text/images writing into the header area
-      graphics_fill_rect(ctx, GRect(bounds.origin.x, bounds.origin.y, bounds.size.w, header_height), 0, GCornerNone);
-      
-      if(console_data->header_text_color.argb!=GColorClear.argb) {
-        graphics_context_set_text_color(ctx, console_data->header_text_color);
-        graphics_draw_text(ctx, console_data->header_text, console_data->header_font, GRect(bounds.origin.x, bounds.origin.y - 3, bounds.size.w, header_height), GTextOverflowModeTrailingEllipsis, console_data->header_text_alignment, NULL);  // y-3 because Pebble's text rendering goes outside rect
-      }
+// Shrinks other layers (down to their minimums, longest idle first) until bytes of the pool are free, or there's
+// nothing more to take.  Only idle layers are shrunk if only_idle.  Returns how much was freed.
+static size_t console_layer_pool_reclaim(ConsoleLayerPool *pool, Layer *console_layer, size_t bytes, bool only_idle) {
+  uint32_t now = console_layer_now_ms();
+  size_t freed = 0;
+  while(freed < bytes) {
+    Layer *victim = NULL;
+    for(uint8_t i=0; i<pool->layer_count; i++) {
+      console_data_struct *console_data = (console_data_struct*)layer_get_data(pool->layers[i]);
+      if(pool->layers[i]!=console_layer && console_data->buffer_size > console_data->min_size &&
+         (!only_idle || now - console_data->last_write_ms >= CONSOLE_LAYER_POOL_IDLE_MS) &&
+         (!victim || console_data->last_write_ms < ((console_data_struct*)layer_get_data(victim))->last_write_ms))
+        victim = pool->layers[i];
     }
-  } // END Draw Header
+    if(!victim)
+      break;
+
+    console_data_struct *console_data = (console_data_struct*)layer_get_data(victim);
+    size_t old_size = console_data->buffer_size;
+    size_t new_size = old_size;
+    while(new_size > console_data->min_size && console_layer_storage_size(old_size) - console_layer_storage_size(new_size) < bytes - freed)
+      new_size = new_size - 4 > console_data->min_size ? new_size - 4 : console_data->min_size;
+    console_layer_relocate(console_data, (uint8_t*)console_data->chunks, new_size);
+    freed += console_layer_storage_size(old_size) - console_layer_storage_size(new_size);
+    console_layer_request_redraw(victim);
+  }
+  return freed;
+}
 
-  // Draw Border
-  if(console_data->border_enabled && console_data->border_thickness>0 && console_data->border_color.argb!=GColorClear.argb) {
-    graphics_context_set_fill_color  (ctx, console_data->border_color);
-    graphics_context_set_stroke_color(ctx, console_data->border_color);
-    if(header_height>0)
-      graphics_draw_line(ctx, GPoint(bounds.origin.x, bounds.origin.y + header_height), GPoint(bounds.origin.x + bounds.size.w, bounds.origin.y + header_height));
-    bounds = layer_get_bounds(console_layer);
-    graphics_fill_rect(ctx, GRect(0, 0, bounds.size.w, console_data->border_thickness), 0, GCornerNone);
-    graphics_fill_rect(ctx, GRect(0, 0, console_data->border_thickness, bounds.size.h), 0, GCornerNone);
-    graphics_fill_rect(ctx, GRect(bounds.size.w-console_data->border_thickness, 0, console_data->border_thickness, bounds.size.h), 0, GCornerNone);
-    graphics_fill_rect(ctx, GRect(0, bounds.size.h-console_data->border_thickness, bounds.size.w, console_data->border_thickness), 0, GCornerNone);
-  } // END Draw Border
+// Grows the layer's buffer by up to grow bytes (no more than its maximum), as far as the pool has room for, taking
+// space from other layers (only idle ones if only_idle)
+static void console_layer_pool_grow(Layer *console_layer, size_t grow, bool only_idle) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  ConsoleLayerPool *pool = console_data->pool;
+  size_t size = POOL_ALIGN(console_data->buffer_size + grow < console_data->max_size ? console_data->buffer_size + grow : console_data->max_size);
+  if(size <= console_data->buffer_size)
+    return;
+
+  size_t needed = console_layer_storage_size(size) - console_layer_storage_size(console_data->buffer_size);
+  size_t free_size = console_layer_pool_get_free(pool);
+  if(free_size < needed)
+    free_size += console_layer_pool_reclaim(pool, console_layer, needed - free_size, only_idle);
+  while(size > console_data->buffer_size && console_layer_storage_size(size) - console_layer_storage_size(console_data->buffer_size) > free_size)
+    size -= 4;  // Grow as far as there's room for
+  if(size <= console_data->buffer_size)
+    return;
+
+  int i = 0;
+  while(pool->layers[i]!=console_layer) i++;
+  console_layer_pool_compact(pool, i);
+  console_layer_relocate(console_data, (uint8_t*)console_data->chunks, size);
 }
 
 // ------------------------------------------------------------------------------------------------------------ //
 
+ConsoleLayerPool* console_layer_pool_create(size_t size) {
+  ConsoleLayerPool *pool = malloc(sizeof(ConsoleLayerPool) + POOL_ALIGN(size));
+  if(pool) {
+    memset(pool, 0, sizeof(ConsoleLayerPool));
+    pool->memory = (uint8_t*)(pool + 1);
+    pool->size   = POOL_ALIGN(size);
+  }
+  return pool;
+}
 
+void console_layer_pool_destroy(ConsoleLayerPool *pool) {
+  if(!pool) return;
+  free(pool->scratch);
+  free(pool);
+}
 
+// Makes room for a layer with a min_size byte buffer (taking it from other layers if it has to) and adds it to the end
+// of the pool.  Returns false if there isn't room.
+static bool console_layer_pool_add(ConsoleLayerPool *pool, Layer *console_layer, size_t min_size, size_t max_size) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(pool->layer_count == CONSOLE_LAYER_POOL_MAX_LAYERS)
+    return false;
+  size_t needed = console_layer_storage_size(min_size);
+  size_t free_size = console_layer_pool_get_free(pool);
+  if(free_size < needed && free_size + console_layer_pool_reclaim(pool, NULL, needed - free_size, false) < needed)
+    return false;
+
+  // Every layer's scratch is the pool's, so it has to be big enough for the biggest
+  if(pool->scratch_size < max_size) {
+    char *scratch = malloc(max_size);
+    if(!scratch)
+      return false;
+    free(pool->scratch);
+    pool->scratch      = scratch;
+    pool->scratch_size = max_size;
+    for(uint8_t i=0; i<pool->layer_count; i++)
+      ((console_data_struct*)layer_get_data(pool->layers[i]))->scratch = scratch;
+  }
 
+  console_layer_pool_compact(pool, pool->layer_count - 1);
+  console_layer_set_storage(console_data, pool->memory + pool->size - console_layer_pool_get_free(pool), min_size);
+  console_data->scratch       = pool->scratch;
+  console_data->pool          = pool;
+  console_data->min_size      = min_size;
+  console_data->max_size      = max_size;
+  console_data->last_write_ms = console_layer_now_ms();
+  pool->layers[pool->layer_count++] = console_layer;
+  return true;
+}
 
-
-
+static void console_layer_pool_remove(Layer *console_layer) {
+  ConsoleLayerPool *pool = ((console_data_struct*)layer_get_data(console_layer))->pool;
+  if(!pool) return;
+  uint8_t i = 0;
+  while(pool->layers[i]!=console_layer) i++;
+  memmove(&pool->layers[i], &pool->layers[i + 1], (--pool->layer_count - i) * sizeof(Layer*));
+}
 
 // ------------------------------------------------------------------------------------------------------------ //
-// Create Layer
+// Buffer Size
 // ------------------------------------------------------------------------------------------------------------ //
+// A layer's own data can't change size, so a layer resized past what it was created with moves its index, buffer and
+// scratch to the heap, and back again if it's shrunk small enough to fit.  On the heap, shrinking happens in place
+// before the block's cut down, so it never needs more memory than it gives back.
+// With adaptive sizing, writes check the heap: a layer that's filling up grows while there's plenty free, and gives
+// memory back (down to its minimum) whenever there's less than heap_headroom left.
+#ifndef CONSOLE_LAYER_ADAPTIVE_GROW_SIZE
+#define CONSOLE_LAYER_ADAPTIVE_GROW_SIZE 256  // Bytes of buffer an adaptive layer grows by at a time
+#endif
+
+// Moves a layer that isn't pooled to a buffer_size byte buffer.  Returns false if there isn't the memory for it.
+static bool console_layer_resize_storage(console_data_struct *console_data, size_t buffer_size) {
+  uint8_t *inline_storage = (uint8_t*)(console_data + 1);
+  if(buffer_size <= console_data->inline_size) {
+    console_layer_relocate(console_data, inline_storage, buffer_size);
+    console_data->scratch = (char*)inline_storage + console_layer_storage_size(console_data->inline_size);
+    free(console_data->heap_storage);
+    console_data->heap_storage = NULL;
+    return true;
+  }
 
-Layer* console_layer_create_with_buffer_size(GRect frame, int buffer_size) {
-  Layer *console_layer;
-  size_t data_size = sizeof (console_data_struct) + buffer_size;
+  size_t size = console_layer_storage_size(buffer_size) + buffer_size;  // index, buffer, scratch
+  uint8_t *storage;
+  if(!console_data->heap_storage) {
+    if(!(storage = malloc(size)))
+      return false;
+    console_layer_relocate(console_data, storage, buffer_size);
+  } else if(buffer_size < console_data->buffer_size) {
+    console_layer_relocate(console_data, console_data->heap_storage, buffer_size);
+    if((storage = realloc(console_data->heap_storage, size)))
+      console_layer_set_storage(console_data, storage, buffer_size);  // In case it moved
+    else
+      storage = console_data->heap_storage;                           // Still fine, just bigger than it needs to be
+  } else {
+    if(!(storage = realloc(console_data->heap_storage, size)))
+      return false;
+    console_layer_set_storage(console_data, storage, console_data->buffer_size);  // In case it moved
+    console_layer_relocate(console_data, storage, buffer_size);
+  }
+  console_data->heap_storage = storage;
+  console_data->scratch      = console_data->buffer + buffer_size;
+  return true;
+}
 
-  if((console_layer = layer_create_with_data(frame, data_size))) {
-    console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
-    console_data->buffer = (char*)(&(console_data->buffer) + sizeof(console_data->buffer));  // Point buffer to memory allocated just after the struct.  Assumes buffer is the last type inside struct.
-    console_data->buffer_size = buffer_size;
+// After each write: grow a layer that's getting full, before it has to start evicting (pooled or adaptive layers), or
+// shrink an adaptive one if the heap's running low
+static void console_layer_wrote(Layer *console_layer) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(!console_data->pool && !console_data->heap_headroom)
+    return;
+  console_data->last_write_ms = console_layer_now_ms();
+  bool full = console_data->buffer_used > console_data->buffer_size / 4 * 3 || console_data->chunk_count > console_data->chunk_capacity / 4 * 3;
+  if(console_data->pool) {
+    if(full)
+      console_layer_pool_grow(console_layer, CONSOLE_LAYER_POOL_GROW_SIZE, true);
+    return;
+  }
 
-    layer_set_clips(console_layer, true);
-    console_layer_set_layer_style(console_layer, GColorBlack, GColorClear, fonts_get_system_font(FONT_KEY_GOTHIC_14), GTextAlignmentLeft, WordWrapFalse, true);
-    console_layer_set_border_style(console_layer, false, GColorBlack, 1);
-    console_layer_set_header_style(console_layer, false, GColorBlack, GColorLightGray, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD), GTextAlignmentCenter);
-    console_layer_set_header_text(console_layer, " ");  // If header is "" then no header is displayed (if enabled)
-    console_layer_clear(console_layer);
-    layer_set_update_proc(console_layer, console_layer_update);
+  size_t heap_free = heap_bytes_free();
+  if(heap_free < console_data->heap_headroom) {
+    console_layer_make_heap_room(console_layer, 0);
+  } else if(full && console_data->buffer_size < console_data->max_size) {
+    size_t size = console_data->buffer_size + CONSOLE_LAYER_ADAPTIVE_GROW_SIZE < console_data->max_size ? console_data->buffer_size + CONSOLE_LAYER_ADAPTIVE_GROW_SIZE : console_data->max_size;
+    if(heap_free >= console_data->heap_headroom + console_layer_storage_size(size) + size)  // Room for the new block, even if it can't grow in place
+      console_layer_resize_storage(console_data, size);
   }
-  return console_layer;
 }
 
 // ------------------------------------------------------------------------------------------------------------ //
 
-Layer* console_layer_create(GRect frame) {
-  return console_layer_create_with_buffer_size(frame, DEFAULT_BUFFER_SIZE);
+int console_layer_set_buffer_size(Layer *console_layer, int buffer_size) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  size_t size = buffer_size > 4 ? (buffer_size < 0xFFFF ? buffer_size : 0xFFFF) : 4;
+  if(console_data->pool) {
+    size = POOL_ALIGN(size < console_data->min_size ? console_data->min_size : size > console_data->max_size ? console_data->max_size : size);
+    if(size > console_data->buffer_size)
+      console_layer_pool_grow(console_layer, size - console_data->buffer_size, false);
+    else if(size < console_data->buffer_size)
+      console_layer_relocate(console_data, (uint8_t*)console_data->chunks, size);
+  } else if(size != console_data->buffer_size) {
+    console_layer_resize_storage(console_data, size);
+  }
+  console_layer_request_redraw(console_layer);
+  return console_data->buffer_size;
 }
 
-// ------------------------------------------------------------------------------------------------------------ //
+void console_layer_set_adaptive_buffer_size(Layer *console_layer, int min_buffer_size, int max_buffer_size, int heap_headroom) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(console_data->pool)  // Pooled layers already grow and shrink within their pool
+    return;
+  console_data->min_size      = min_buffer_size > 4 ? (min_buffer_size < 0xFFFF ? min_buffer_size : 0xFFFF) : 4;
+  console_data->max_size      = max_buffer_size > console_data->min_size ? (max_buffer_size < 0xFFFF ? max_buffer_size : 0xFFFF) : console_data->min_size;
+  console_data->heap_headroom = heap_headroom > 0 ? (heap_headroom < 0xFFFF ? heap_headroom : 0xFFFF) : 0;
+  if(console_data->heap_headroom && (console_data->buffer_size < console_data->min_size || console_data->buffer_size > console_data->max_size))
+    console_layer_set_buffer_size(console_layer, console_data->buffer_size < console_data->min_size ? console_data->min_size : console_data->max_size);
+}
+
+int console_layer_make_heap_room(Layer *console_layer, size_t bytes) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(!console_data->heap_headroom || !console_data->heap_storage)
+    return console_data->buffer_size;
+
+  // Shrinking by n bytes of buffer gives back more than n (its scratch and index go too), so this can overshoot a little
+  size_t wanted = bytes + console_data->heap_headroom, heap_free = heap_bytes_free();
+  if(heap_free < wanted) {
+    size_t shrink = wanted - heap_free;
+    size_t size   = console_data->buffer_size > console_data->min_size + shrink ? console_data->buffer_size - shrink : console_data->min_size;
+    if(size < console_data->buffer_size)
+      console_layer_set_buffer_size(console_layer, size);
+  }
+  return console_data->buffer_size;
+}
+
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+// ------------------------------------------------------------------------------------------------------------ //
+// Style Table
+// ------------------------------------------------------------------------------------------------------------ //
+static uint8_t console_layer_make_style_settings(GTextAlignment alignment, int word_wrap) {
+  return (word_wrap&WORD_WRAP_BITS) | (alignment==GTextAlignmentLeft?0b0000 : alignment==GTextAlignmentCenter?0b0100 : alignment==GTextAlignmentRight?0b1000 : 0b1100);
+}
+
+static bool console_layer_style_matches(console_style *style, GColor text_color, GColor background_color, GFont font, uint8_t settings) {
+  return style->font == font && style->text_color.argb == text_color.argb && style->background_color.argb == background_color.argb && style->settings == settings;
+}
+
+// Returns the ID of the style, adding it to the table if it isn't there yet.
+// If the table's full, the unpinned style that was last used longest ago is replaced, and any chunks still using it are
+// evicted (there's always at least one unpinned style).
+static uint8_t console_layer_intern_style(console_data_struct *console_data, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap) {
+  uint8_t settings = console_layer_make_style_settings(alignment, word_wrap);
+  
+  // Most of the time it's the same style as last time
+  if(console_data->last_style < console_data->style_count && console_layer_style_matches(&console_data->styles[console_data->last_style], text_color, background_color, font, settings))
+    return console_data->last_style;
+  
+  for(uint8_t i=0; i<console_data->style_count; i++)
+    if(console_layer_style_matches(&console_data->styles[i], text_color, background_color, font, settings))
+      return (console_data->last_style = i);
+  
+  uint8_t id = NO_STYLE;
+  if(console_data->style_count < CONSOLE_LAYER_MAX_STYLES) {
+    id = console_data->style_count++;
+  } else {
+    // Find how many chunks (oldest first) would have to go to free up each style
+    uint16_t last_used[CONSOLE_LAYER_MAX_STYLES] = {0};
+    for(uint16_t n=0; n<console_data->chunk_count; n++)
+      last_used[console_data->buffer[console_layer_get_chunk(console_data, n)->offset] & STYLE_ID_BITS] = n + 1;
+    for(uint8_t i=0; i<console_data->style_count; i++)
+      if(!console_data->styles[i].pinned && (id == NO_STYLE || last_used[i] < last_used[id]))
+        id = i;
+    for(uint16_t n=last_used[id]; n>0; n--)
+      console_layer_evict_chunk(console_data);
+  }
+  
+  console_data->styles[id] = (console_style){.font=font, .text_color=text_color, .background_color=background_color, .settings=settings, .pinned=false};
+  console_layer_persist_touch_styles(console_data);
+  return (console_data->last_style = id);
+}
+
+int console_layer_register_style(Layer *console_layer, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  uint8_t settings = console_layer_make_style_settings(alignment, word_wrap);
+  uint8_t pinned = 0;
+  for(uint8_t i=0; i<console_data->style_count; i++) {
+    if(console_layer_style_matches(&console_data->styles[i], text_color, background_color, font, settings)) {
+      console_data->styles[i].pinned = true;
+      console_layer_persist_touch_styles(console_data);
+      return i;
+    }
+    if(console_data->styles[i].pinned) pinned++;
+  }
+  
+  // Keep at least one style free for everything else
+  if(pinned >= CONSOLE_LAYER_MAX_STYLES - 1)
+    return -1;
+  
+  uint8_t id = console_layer_intern_style(console_data, text_color, background_color, font, alignment, word_wrap);
+  console_data->styles[id].pinned = true;
+  console_layer_persist_touch_styles(console_data);
+  return id;
+}
+
+void console_layer_set_text_style_id(Layer *console_layer, int style_id) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(style_id < 0 || style_id >= console_data->style_count) return;
+  
+  console_style *style = &console_data->styles[style_id];
+  GTextAlignment alignment;
+  switch (style->settings & ALIGNMENT_BITS) {
+    case 0b0000: alignment = GTextAlignmentLeft;    break;
+    case 0b0100: alignment = GTextAlignmentCenter;  break;
+    case 0b1000: alignment = GTextAlignmentRight;   break;
+    default:     alignment = GTextAlignmentInherit;
+  }
+  int word_wrap = style->settings&WORD_WRAP_INHERIT_BIT ? WordWrapInherit : style->settings&WORD_WRAP_BIT;
+  console_layer_set_text_style(console_layer, style->text_color, style->background_color, style->font, alignment, word_wrap);
+}
+#endif
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Mono Font
+// ------------------------------------------------------------------------------------------------------------ //
+// CONSOLE_LAYER_FONT_MONO is a fixed width 5x7 font in 6x9 pixel cells.  It's laid out with a bit of arithmetic
+// instead of graphics_text_layout_get_content_size, and drawn by writing glyph rows straight into the frame buffer
+// instead of with graphics_draw_text: each pixel row of a line of text is put together as 32 bit words of pixels, then
+// written out a word at a time (32 pixels on 1 bit displays, 4 on 8 bit ones).
+#ifndef CONSOLE_LAYER_NO_MONO_FONT
+#define MONO_GLYPH_WIDTH  6
+#define MONO_LINE_HEIGHT  9
+#define MONO_GLYPH_ROWS   7
+#define MONO_GLYPH_TOP    1  // Blank rows above the glyphs in a line
+
+// Printable ASCII, 7 rows per glyph, leftmost pixel in the lowest bit
+const uint8_t console_layer_mono_font[] = {
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00, 0x04,0x04,0x04,0x04,0x04,0x00,0x04, 0x0A,0x0A,0x0A,0x00,0x00,0x00,0x00, 0x0A,0x0A,0x1F,0x0A,0x1F,0x0A,0x0A, //   ! " #
+  0x04,0x1E,0x05,0x0E,0x14,0x0F,0x04, 0x03,0x13,0x08,0x04,0x02,0x19,0x18, 0x06,0x09,0x05,0x02,0x15,0x09,0x16, 0x06,0x04,0x02,0x00,0x00,0x00,0x00, // $ % & '
+  0x08,0x04,0x02,0x02,0x02,0x04,0x08, 0x02,0x04,0x08,0x08,0x08,0x04,0x02, 0x00,0x04,0x15,0x0E,0x15,0x04,0x00, 0x00,0x04,0x04,0x1F,0x04,0x04,0x00, // ( ) * +
+  0x00,0x00,0x00,0x00,0x06,0x04,0x02, 0x00,0x00,0x00,0x1F,0x00,0x00,0x00, 0x00,0x00,0x00,0x00,0x00,0x06,0x06, 0x00,0x10,0x08,0x04,0x02,0x01,0x00, // , - . /
+  0x0E,0x11,0x19,0x15,0x13,0x11,0x0E, 0x04,0x06,0x04,0x04,0x04,0x04,0x0E, 0x0E,0x11,0x10,0x08,0x04,0x02,0x1F, 0x1F,0x08,0x04,0x08,0x10,0x11,0x0E, // 0 1 2 3
+  0x08,0x0C,0x0A,0x09,0x1F,0x08,0x08, 0x1F,0x01,0x0F,0x10,0x10,0x11,0x0E, 0x0C,0x02,0x01,0x0F,0x11,0x11,0x0E, 0x1F,0x10,0x08,0x04,0x02,0x02,0x02, // 4 5 6 7
+  0x0E,0x11,0x11,0x0E,0x11,0x11,0x0E, 0x0E,0x11,0x11,0x1E,0x10,0x08,0x06, 0x00,0x06,0x06,0x00,0x06,0x06,0x00, 0x00,0x06,0x06,0x00,0x06,0x04,0x02, // 8 9 : ;
+  0x08,0x04,0x02,0x01,0x02,0x04,0x08, 0x00,0x00,0x1F,0x00,0x1F,0x00,0x00, 0x02,0x04,0x08,0x10,0x08,0x04,0x02, 0x0E,0x11,0x10,0x08,0x04,0x00,0x04, // < = > ?
+  0x0E,0x11,0x10,0x16,0x15,0x15,0x0E, 0x0E,0x11,0x11,0x11,0x1F,0x11,0x11, 0x0F,0x11,0x11,0x0F,0x11,0x11,0x0F, 0x0E,0x11,0x01,0x01,0x01,0x11,0x0E, // @ A B C
+  0x07,0x09,0x11,0x11,0x11,0x09,0x07, 0x1F,0x01,0x01,0x0F,0x01,0x01,0x1F, 0x1F,0x01,0x01,0x0F,0x01,0x01,0x01, 0x0E,0x11,0x01,0x1D,0x11,0x11,0x1E, // D E F G
+  0x11,0x11,0x11,0x1F,0x11,0x11,0x11, 0x0E,0x04,0x04,0x04,0x04,0x04,0x0E, 0x1C,0x08,0x08,0x08,0x08,0x09,0x06, 0x11,0x09,0x05,0x03,0x05,0x09,0x11, // H I J K
+  0x01,0x01,0x01,0x01,0x01,0x01,0x1F, 0x11,0x1B,0x15,0x15,0x11,0x11,0x11, 0x11,0x11,0x13,0x15,0x19,0x11,0x11, 0x0E,0x11,0x11,0x11,0x11,0x11,0x0E, // L M N O
+  0x0F,0x11,0x11,0x0F,0x01,0x01,0x01, 0x0E,0x11,0x11,0x11,0x15,0x09,0x16, 0x0F,0x11,0x11,0x0F,0x05,0x09,0x11, 0x1E,0x01,0x01,0x0E,0x10,0x10,0x0F, // P Q R S
+  0x1F,0x04,0x04,0x04,0x04,0x04,0x04, 0x11,0x11,0x11,0x11,0x11,0x11,0x0E, 0x11,0x11,0x11,0x11,0x11,0x0A,0x04, 0x11,0x11,0x11,0x15,0x15,0x15,0x0A, // T U V W
+  0x11,0x11,0x0A,0x04,0x0A,0x11,0x11, 0x11,0x11,0x11,0x0A,0x04,0x04,0x04, 0x1F,0x10,0x08,0x04,0x02,0x01,0x1F, 0x0E,0x02,0x02,0x02,0x02,0x02,0x0E, // X Y Z [
+  0x00,0x01,0x02,0x04,0x08,0x10,0x00, 0x0E,0x08,0x08,0x08,0x08,0x08,0x0E, 0x04,0x0A,0x11,0x00,0x00,0x00,0x00, 0x00,0x00,0x00,0x00,0x00,0x00,0x1F, // \ ] ^ _
+  0x02,0x04,0x08,0x00,0x00,0x00,0x00, 0x00,0x00,0x0E,0x10,0x1E,0x11,0x1E, 0x01,0x01,0x0D,0x13,0x11,0x11,0x0F, 0x00,0x00,0x0E,0x01,0x01,0x11,0x0E, // ` a b c
+  0x10,0x10,0x16,0x19,0x11,0x11,0x1E, 0x00,0x00,0x0E,0x11,0x1F,0x01,0x0E, 0x0C,0x12,0x02,0x07,0x02,0x02,0x02, 0x00,0x1E,0x11,0x11,0x1E,0x10,0x0E, // d e f g
+  0x01,0x01,0x0D,0x13,0x11,0x11,0x11, 0x04,0x00,0x06,0x04,0x04,0x04,0x0E, 0x08,0x00,0x0C,0x08,0x08,0x09,0x06, 0x01,0x01,0x09,0x05,0x03,0x05,0x09, // h i j k
+  0x06,0x04,0x04,0x04,0x04,0x04,0x0E, 0x00,0x00,0x0B,0x15,0x15,0x11,0x11, 0x00,0x00,0x0D,0x13,0x11,0x11,0x11, 0x00,0x00,0x0E,0x11,0x11,0x11,0x0E, // l m n o
+  0x00,0x00,0x0F,0x11,0x0F,0x01,0x01, 0x00,0x00,0x16,0x19,0x1E,0x10,0x10, 0x00,0x00,0x0D,0x13,0x01,0x01,0x01, 0x00,0x00,0x0E,0x01,0x0E,0x10,0x0F, // p q r s
+  0x02,0x02,0x07,0x02,0x02,0x12,0x0C, 0x00,0x00,0x11,0x11,0x11,0x19,0x16, 0x00,0x00,0x11,0x11,0x11,0x0A,0x04, 0x00,0x00,0x11,0x11,0x15,0x15,0x0A, // t u v w
+  0x00,0x00,0x11,0x0A,0x04,0x0A,0x11, 0x00,0x00,0x11,0x11,0x1E,0x10,0x0E, 0x00,0x00,0x1F,0x08,0x04,0x02,0x1F, 0x08,0x04,0x04,0x02,0x04,0x04,0x08, // x y z {
+  0x04,0x04,0x04,0x04,0x04,0x04,0x04, 0x02,0x04,0x04,0x08,0x04,0x04,0x02, 0x00,0x00,0x02,0x15,0x08,0x00,0x00,                                     // | } ~
+};
+
+// Glyph to draw for the character at *text, moving text past it (a whole UTF-8 sequence)
+static const uint8_t* console_layer_mono_glyph(const char **text) {
+  uint8_t c = *(*text)++;
+  if(c >= 0x80) {
+    bool times = c==0xC3 && (uint8_t)**text==0x97;  // ×, drawn as x
+    while(((uint8_t)**text & 0xC0) == 0x80) (*text)++;
+    c = times ? 'x' : '?';
+  } else if(c < 0x20 || c > 0x7E) {
+    c = '?';
+  }
+  return &console_layer_mono_font[(c - 0x20) * MONO_GLYPH_ROWS];
+}
+
+// Finds the end of the line starting at text that fits in columns characters (without word wrap, just the first line
+// and what of it fits).  Returns how many characters the line has and where the next one starts in *next (NULL at the
+// end of the text).
+static int16_t console_layer_mono_line(const char *text, int16_t columns, bool word_wrap, const char **end, const char **next) {
+  int16_t length = 0, break_length = 0;
+  const char *c = text, *break_end = NULL;
+  if(columns < 1)
+    columns = 1;  // (Always gets somewhere)
+  while(*c && *c!='\n') {
+    if(*c==' ') {
+      break_end = c;
+      break_length = length;
+    }
+    if(length == columns) {
+      if(!word_wrap)
+        break;
+      if(break_end) {  // Wrap at the last space, leaving it out
+        *end  = break_end;
+        *next = break_end + 1;
+        return break_length;
+      }
+      *end = *next = c;  // One long word: wrap mid-word
+      return length;
+    }
+    console_layer_mono_glyph(&c);
+    length++;
+  }
+  *end  = c;
+  *next = word_wrap && *c=='\n' && c[1] ? c + 1 : NULL;
+  return length;
+}
+
+static GSize console_layer_measure_mono_text(const char *text, bool word_wrap, int16_t width) {
+  int16_t columns = width / MONO_GLYPH_WIDTH, widest = 0, lines = 0;
+  const char *end;
+  for(const char *line = text; line; lines++) {
+    int16_t length = console_layer_mono_line(line, columns, word_wrap, &end, &line);
+    if(length > widest) widest = length;
+  }
+  return GSize(widest * MONO_GLYPH_WIDTH, lines * MONO_LINE_HEIGHT);
+}
+
+// Writes the set bits of a row of pixels (bits[0] bit 0 = x 0) between x0 and x1 into a frame buffer row
+static void console_layer_write_mono_row(GBitmapDataRowInfo *row, bool bits_per_pixel_1, uint16_t bytes_per_row, uint32_t *bits, int16_t x0, int16_t x1, GColor color) {
+  static const uint32_t expand[16] = {  // 4 pixels' bits to 4 pixels' bytes
+    0x00000000, 0x000000FF, 0x0000FF00, 0x0000FFFF, 0x00FF0000, 0x00FF00FF, 0x00FFFF00, 0x00FFFFFF,
+    0xFF000000, 0xFF0000FF, 0xFF00FF00, 0xFF00FFFF, 0xFFFF0000, 0xFFFF00FF, 0xFFFFFF00, 0xFFFFFFFF};
+  bool white = gcolor_equal(color, GColorWhite);
+  uint32_t color_word = color.argb * 0x01010101u;
+  for(int16_t w = x0 / 32; w <= x1 / 32; w++) {
+    uint32_t word = bits[w];
+    if(w == x0 / 32) word &= 0xFFFFFFFFu << (x0 % 32);
+    if(w == x1 / 32) word &= 0xFFFFFFFFu >> (31 - x1 % 32);
+    if(!word)
+      continue;
+    if(bits_per_pixel_1) {  // 32 pixels at a time, leftmost pixel in the lowest bit
+      uint8_t *data = row->data + w * 4;
+      if(w * 4 + 4 <= bytes_per_row) {
+        uint32_t pixels;
+        memcpy(&pixels, data, 4);
+        pixels = white ? pixels | word : pixels & ~word;
+        memcpy(data, &pixels, 4);
+      } else {
+        for(int16_t b = 0; b < 4 && w * 4 + b < bytes_per_row; b++, word >>= 8)
+          data[b] = white ? data[b] | (uint8_t)word : data[b] & ~(uint8_t)word;
+      }
+    } else {  // 4 pixels at a time
+      for(int16_t x = w * 32; word; x += 4, word >>= 4) {
+        uint32_t nibble = word & 0xF;
+        if(!nibble)
+          continue;
+        if(x >= row->min_x && x + 3 <= row->max_x) {
+          uint32_t pixels;
+          memcpy(&pixels, row->data + x, 4);
+          pixels = (pixels & ~expand[nibble]) | (color_word & expand[nibble]);
+          memcpy(row->data + x, &pixels, 4);
+        } else {
+          for(int16_t i = 0; i < 4; i++)
+            if(nibble & (1 << i))
+              row->data[x + i] = color.argb;
+        }
+      }
+    }
+  }
+}
+
+// Draws text in box (layer coordinates), clipped to it and the layer
+static void console_layer_draw_mono_text(console_data_struct *console_data, GContext *ctx, const char *text, bool word_wrap, GRect box, GTextAlignment alignment, GColor color) {
+  if(color.argb == GColorClear.argb)
+    return;
+  GRect clip = console_data->screen_bounds;
+  box.origin.x += clip.origin.x;  // To screen coordinates
+  box.origin.y += clip.origin.y;
+  grect_clip(&clip, &box);
+  if(clip.size.w <= 0 || clip.size.h <= 0)
+    return;
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if(!frame_buffer)
+    return;
+  GBitmapFormat format = gbitmap_get_format(frame_buffer);
+  if(format==GBitmapFormat1Bit || format==GBitmapFormat8Bit || format==GBitmapFormat8BitCircular) {
+    bool bits_per_pixel_1 = format == GBitmapFormat1Bit;
+    uint16_t bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+    GRect frame = gbitmap_get_bounds(frame_buffer);
+    grect_clip(&clip, &frame);
+    int16_t columns = box.size.w / MONO_GLYPH_WIDTH;
+    const char *end, *next;
+    for(int16_t top = box.origin.y; text && top < clip.origin.y + clip.size.h; top += MONO_LINE_HEIGHT, text = next) {
+      int16_t length = console_layer_mono_line(text, columns, word_wrap, &end, &next);
+      if(top + MONO_GLYPH_TOP + MONO_GLYPH_ROWS <= clip.origin.y || length == 0)
+        continue;
+      int16_t left = box.origin.x;
+      switch (alignment) {
+        case GTextAlignmentCenter: left += (box.size.w - length * MONO_GLYPH_WIDTH) / 2; break;
+        case GTextAlignmentRight:  left +=  box.size.w - length * MONO_GLYPH_WIDTH;      break;
+        default: break;
+      }
+      // Look up the glyphs on screen once for all their rows
+      const uint8_t *glyphs[PBL_DISPLAY_WIDTH / MONO_GLYPH_WIDTH + 2];
+      int16_t glyph_count = 0, first_x = left;
+      for(const char *c = text; c < end && glyph_count < (int16_t)(sizeof(glyphs) / sizeof(glyphs[0])); ) {
+        const uint8_t *glyph = console_layer_mono_glyph(&c);
+        if(first_x + MONO_GLYPH_WIDTH <= clip.origin.x && glyph_count == 0)
+          first_x += MONO_GLYPH_WIDTH;  // Off the left
+        else if(first_x + glyph_count * MONO_GLYPH_WIDTH < clip.origin.x + clip.size.w)
+          glyphs[glyph_count++] = glyph;
+        else
+          break;  // Off the right
+      }
+
+      for(int16_t r = 0; r < MONO_GLYPH_ROWS; r++) {
+        int16_t y = top + MONO_GLYPH_TOP + r;
+        if(y < clip.origin.y || y >= clip.origin.y + clip.size.h)
+          continue;
+        GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame_buffer, y);
+        int16_t x0 = clip.origin.x > row.min_x ? clip.origin.x : row.min_x;
+        int16_t x1 = clip.origin.x + clip.size.w - 1 < row.max_x ? clip.origin.x + clip.size.w - 1 : row.max_x;
+        if(x0 > x1)
+          continue;
+
+        // Put the row of pixels together, then write it out
+        uint32_t bits[(PBL_DISPLAY_WIDTH + 31) / 32 + 1] = {0};
+        int16_t x = first_x;
+        for(int16_t g = 0; g < glyph_count; g++, x += MONO_GLYPH_WIDTH) {
+          uint32_t glyph_row = glyphs[g][r];
+          if(!glyph_row)
+            continue;
+          if(x < 0)
+            glyph_row >>= -x;
+          int16_t at = x < 0 ? 0 : x;
+          bits[at / 32] |= glyph_row << (at % 32);
+          if(at % 32 > 32 - MONO_GLYPH_WIDTH)
+            bits[at / 32 + 1] |= glyph_row >> (32 - at % 32);
+        }
+        console_layer_write_mono_row(&row, bits_per_pixel_1, bytes_per_row, bits, x0, x1, color);
+      }
+    }
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+}
+#endif
+
+// Draws text in box (layer coordinates, the top of the text at the top of the box)
+static void console_layer_draw_text(console_data_struct *console_data, GContext *ctx, const char *text, GFont font, bool word_wrap, GRect box, GTextAlignment alignment, GColor color) {
+#ifndef CONSOLE_LAYER_NO_MONO_FONT
+  if(font == CONSOLE_LAYER_FONT_MONO) {
+    console_layer_draw_mono_text(console_data, ctx, text, word_wrap, box, alignment, color);
+    return;
+  }
+#endif
+  box.origin.y -= 3;  // Pebble's text rendering is dumb and goes outside rect
+  graphics_draw_text(ctx, text, font, box, GTextOverflowModeTrailingEllipsis, alignment, NULL);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Layout Cache
+// ------------------------------------------------------------------------------------------------------------ //
+// Chunks never change once written (except the newest one being carried on in a batch, which is re-measured), so a
+// chunk's height only depends on the inherited layer settings and the width it's wrapped to.  Heights are stored in the chunk's index entry.
+
+// Width available to text: the layer's bounds less the border and the internal margin
+static int16_t console_layer_get_text_width(Layer *console_layer) {
+  int16_t width = layer_get_bounds(console_layer).size.w;
+#ifndef CONSOLE_LAYER_NO_BORDER
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(console_data->border_enabled && console_data->border_thickness>0)
+    width -= 2 * console_data->border_thickness;
+#endif
+  return width - 2 * MARGIN_LEFT_RIGHT;
+}
+
+static void console_layer_flush_layout_cache(console_data_struct *console_data) {
+  for(uint16_t n=0; n<console_data->chunk_count; n++)
+    console_layer_get_chunk(console_data, n)->height = LAYOUT_UNMEASURED;
+}
+
+// Throws out every cached height if the font, word wrap, alignment or width they were measured with has changed
+// (A height-only change, such as layer_set_frame() shrinking the layer vertically, keeps the cache)
+static void console_layer_check_layout_cache(console_data_struct *console_data, int16_t width) {
+  if(console_data->layout_width     != width                          ||
+     console_data->layout_font      != console_data->layer_font       ||
+     console_data->layout_alignment != console_data->layer_alignment  ||
+     console_data->layout_word_wrap != console_data->layer_word_wrap) {
+    console_layer_flush_layout_cache(console_data);
+    console_data->layout_width     = width;
+    console_data->layout_font      = console_data->layer_font;
+    console_data->layout_alignment = console_data->layer_alignment;
+    console_data->layout_word_wrap = console_data->layer_word_wrap;
+  }
+}
+
+static GSize console_layer_measure_text(console_data_struct *console_data, char *text, GFont font, bool word_wrap, GTextAlignment alignment, int16_t width) {
+#ifndef CONSOLE_LAYER_NO_MONO_FONT
+  if(font == CONSOLE_LAYER_FONT_MONO)
+    return console_layer_measure_mono_text(text, word_wrap, width);
+#endif
+  COUNT_STAT(console_data, measure_calls, 1);
+  return graphics_text_layout_get_content_size(word_wrap?text:" ", font, GRect(0, 0, width, 0x7FFF), GTextOverflowModeTrailingEllipsis, alignment);
+}
+
+// Returns the height of a chunk's text_length bytes of text wrapped to width, only measuring it if it isn't already in
+// the cache.  Every fragment of a chunk is on the same row, so it's as tall as its tallest fragment.
+// With round layout, rows are wrapped to different widths as they move up the screen.  Text wraps the same way at any
+// width from its widest line up to the width it was wrapped to, so the cached height is kept for all of those.
+static int16_t console_layer_get_text_height(console_data_struct *console_data, console_chunk *chunk, char *text, size_t text_length, GFont font, bool word_wrap, GTextAlignment alignment, int16_t width) {
+#ifdef PBL_ROUND
+  if(width < chunk->width_min || width > chunk->width_max)
+    chunk->height = LAYOUT_UNMEASURED;
+#endif
+  if(chunk->height == LAYOUT_UNMEASURED) {
+    char *fragment = text;
+    chunk->height = 0;
+#ifdef PBL_ROUND
+    chunk->width_min = 0;
+    chunk->width_max = word_wrap ? width : 0xFF;  // (Without word wrap it's one line tall at any width)
+#endif
+    do {
+      GSize size = console_layer_measure_text(console_data, fragment, font, word_wrap, alignment, width);
+      if(size.h > chunk->height) chunk->height = size.h;
+#ifdef PBL_ROUND
+      if(word_wrap && size.w > chunk->width_min) chunk->width_min = size.w;
+#endif
+      fragment += strlen(fragment) + 1;
+    } while(word_wrap && fragment < text + text_length);  // Without word wrap they're all one line tall
+  }
+  return chunk->height;
+}
+
+#ifdef PBL_ROUND
+// ------------------------------------------------------------------------------------------------------------ //
+// Round Layout
+// ------------------------------------------------------------------------------------------------------------ //
+// The screen is a circle as wide as the display.  How far across it each pixel row of the rows area is gets worked out
+// once (whenever the rows area moves or changes size), so laying out a row is just looking up the rows at its top and
+// bottom: the screen's narrowest across a row at one end or the other.  Row widths are rounded down to a multiple of
+// ROUND_WIDTH_STEP, so cached heights are good for a row's next few positions as it moves up.
+#ifndef CONSOLE_LAYER_ROUND_MIN_WIDTH
+#define CONSOLE_LAYER_ROUND_MIN_WIDTH 40  // Narrowest a row is laid out (pixels)
+#endif
+#define ROUND_WIDTH_STEP 8
+
+static int32_t console_layer_isqrt(int32_t n) {
+  int32_t root = 0, bit = 1 << 30;
+  while(bit > n)
+    bit >>= 2;
+  for(; bit > 0; bit >>= 2) {
+    if(n >= root + bit) {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+  }
+  return root;
+}
+
+// Notes where the rows area (margin_bounds) is on screen, and if it's moved or changed size since the last frame,
+// forgets every row's remembered width
+static void console_layer_check_round_frame(Layer *console_layer, GRect margin_bounds) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(!console_data->round_layout)
+    return;
+  GRect frame = layer_convert_rect_to_screen(console_layer, margin_bounds);
+  if(grect_equal(&frame, &console_data->round_frame))
+    return;
+  console_data->round_frame = frame;
+  console_layer_flush_layout_cache(console_data);  // (Rows starting where they did before might not be as wide now)
+}
+
+// Where the chord of the screen across pixel row y of the rows area starts and ends, in *left and *right
+static void console_layer_get_round_inset(console_data_struct *console_data, int16_t y, int16_t *left, int16_t *right) {
+  GRect   frame    = console_data->round_frame;
+  int32_t diameter = PBL_DISPLAY_WIDTH;
+  int32_t dy       = 2 * (frame.origin.y + y) + 1 - PBL_DISPLAY_HEIGHT;  // Middle of the pixel row from the middle of the screen, in half pixels
+  int32_t half     = dy*dy < diameter*diameter ? console_layer_isqrt(diameter*diameter - dy*dy) / 2 : 0;
+  int32_t l        = PBL_DISPLAY_WIDTH / 2 - half - frame.origin.x;
+  int32_t r        = PBL_DISPLAY_WIDTH / 2 + half - frame.origin.x;
+  *left  = l < 0 ? 0 : l > frame.size.w ? frame.size.w : l;
+  *right = r < *left ? *left : r > frame.size.w ? frame.size.w : r;
+}
+
+// Widest row (rounded down to ROUND_WIDTH_STEP) that fits the screen from top to bottom (exclusive) in the rows area,
+// and where it starts in *x
+static int16_t console_layer_get_round_chord(console_data_struct *console_data, int16_t top, int16_t bottom, int16_t *x) {
+  int16_t last = console_data->round_frame.size.h - 1;
+  bottom = bottom - 1 > last ? last : bottom - 1;
+  bottom = bottom < 0 ? 0 : bottom;
+  top    = top < 0 ? 0 : top > bottom ? bottom : top;
+  int16_t top_left, top_right, bottom_left, bottom_right;
+  console_layer_get_round_inset(console_data, top,    &top_left,    &top_right);
+  console_layer_get_round_inset(console_data, bottom, &bottom_left, &bottom_right);
+  int16_t left  = top_left  > bottom_left  ? top_left  : bottom_left;
+  int16_t right = top_right < bottom_right ? top_right : bottom_right;
+  int16_t width = right > left ? (right - left) & ~(ROUND_WIDTH_STEP - 1) : 0;
+  *x = left + (right - left - width) / 2;
+  return width;
+}
+
+// Lays a chunk's text out in the widest row that fits the screen from the row's bottom as far up as the text reaches:
+// first in the chord across what's on the row already, then again (up to twice) if it turns out taller than that.
+// Returns its height, and where the row is in *x and *width.
+// Where a row starting with the chunk goes is remembered, so it isn't worked out (and measured at each width tried)
+// again every frame until the row moves.
+static int16_t console_layer_get_round_text_height(console_data_struct *console_data, console_chunk *chunk, char *text, size_t text_length, GFont font, bool word_wrap, GTextAlignment alignment, int16_t bottom, int16_t row_height, int16_t *x, int16_t *width) {
+  if(row_height == 0 && chunk->round_bottom == bottom && chunk->height != LAYOUT_UNMEASURED) {
+    *x     = chunk->round_x;
+    *width = chunk->round_width;
+    return chunk->height;
+  }
+  int16_t height = row_height, text_height;
+  for(int tries = 3; ; height = text_height) {
+    *width = console_layer_get_round_chord(console_data, bottom - height, bottom, x);
+    text_height = console_layer_get_text_height(console_data, chunk, text, text_length, font, word_wrap, alignment, *width);
+    if(text_height <= height || --tries == 0)
+      break;
+  }
+  chunk->round_bottom = row_height == 0 ? bottom : ROUND_UNLAID;
+  chunk->round_x      = *x;
+  chunk->round_width  = *width;
+  return text_height;
+}
+
+void console_layer_set_round_layout(Layer *console_layer, bool round_layout) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_data->round_layout = round_layout;
+  console_data->round_frame  = GRect(0, 0, 0, -1);  // Worked out again next frame
+  console_data->redraw_full = true;
+  console_layer_mark_dirty(console_layer);
+}
+#endif
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+// ------------------------------------------------------------------------------------------------------------ //
+// Compact Text
+// ------------------------------------------------------------------------------------------------------------ //
+// Byte 0x80 + t stands for compact_tokens[t].  Picked for how much they shrink a mix of English and log lines, and
+// sorted by first character (longest first), so packing only has to look through the ones starting with the next one.
+static const char compact_tokens[128][4] = {
+  " of ", " the", " to ", " in",  " (",   " a",   " b",   " c",
+  " d",   " f",   " i",   " m",   " p",   " r",   " s",   " w",
+  ") ",   ", ",   ". ",   "00",   "10",   "20",   ": ",   "ERR",
+  "alue", "and ", "ac",   "ad",   "al",   "an",   "ar",   "as",
+  "at",   "be",   "ceiv", "conn", "ca",   "ce",   "ch",   "co",
+  "ct",   "d ",   "de",   "di",   "ect",  "ent",  "er ",  "es ",
+  "e ",   "ea",   "ed",   "el",   "en",   "er",   "es",   "fail",
+  "fo",   "ge",   "ha",   "he",   "hi",   "ho",   "ing ", "ing",
+  "ion",  "ic",   "ie",   "il",   "in",   "is",   "it",   "load",
+  "la",   "le",   "li",   "ll",   "lo",   "ly",   "ment", "ma",
+  "me",   "ms",   "n ",   "nd",   "ne",   "ng",   "no",   "ns",
+  "nt",   "ount", "o ",   "of",   "ol",   "om",   "on",   "or",
+  "ou",   "pe",   "po",   "r ",   "ra",   "re",   "ri",   "ro",
+  "sage", "sent", "s ",   "se",   "so",   "ss",   "st",   "the ",
+  "time", "tion", "ter",  "t ",   "ta",   "te",   "th",   "ti",
+  "to",   "tr",   "un",   "ur",   "us",   "ut",   "ve",   "y ",
+};
+
+static size_t console_layer_token_length(uint8_t t) {
+  return compact_tokens[t][3] ? 4 : strlen(compact_tokens[t]);
+}
+
+// Whether text can be packed: it has to be plain ASCII
+static bool console_layer_can_compact(const char *begin, const char *end) {
+  while(begin<end)
+    if(*begin++ & 0x80) return false;
+  return true;
+}
+
+// Packs the text at *text (up to end) into one byte, the longest token it starts with or else its first character,
+// and moves *text past what was packed
+static uint8_t console_layer_compact_next(const char **text, const char *end) {
+  static uint8_t first_token[95];  // First token starting with each printable character (128 = none), worked out once
+  static bool    first_token_found;
+  if(!first_token_found) {
+    memset(first_token, 128, sizeof(first_token));
+    for(uint8_t t=128; t-->0;)
+      first_token[compact_tokens[t][0] - ' '] = t;
+    first_token_found = true;
+  }
+
+  char c = **text;
+  size_t left = end - *text;
+  for(uint8_t t=c>=' ' && c<127 ? first_token[c - ' '] : 128; t<128 && compact_tokens[t][0]==c; t++) {
+    const char *token = compact_tokens[t], *next = *text;
+    size_t length = 1;
+    while(length < 4 && token[length] && length < left && next[length]==token[length]) length++;
+    if(length==4 || !token[length]) {  // Matched the whole token
+      *text += length;
+      return 0x80 | t;
+    }
+  }
+  (*text)++;
+  return c;
+}
+
+// Unpacks length bytes of packed text, starting at index (which may wrap around the end of the buffer), into out.  It's
+// cut short if it doesn't fit in room bytes (and a terminating 0).  Returns the length unpacked.
+static size_t console_layer_expand_text(console_data_struct *console_data, size_t index, size_t length, char *out, size_t room) {
+  size_t out_length = 0;
+  for(size_t i=0; i<length; i++) {
+    uint8_t c = console_data->buffer[(index + i) % console_data->buffer_size];
+    size_t token_length = c&0x80 ? console_layer_token_length(c&0x7F) : 1;
+    if(out_length + token_length >= room)
+      break;
+    if(c&0x80)
+      memcpy(&out[out_length], compact_tokens[c&0x7F], token_length);
+    else
+      out[out_length] = c;
+    out_length += token_length;
+  }
+  out[out_length] = 0;
+  return out_length;
+}
+#endif
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Write Layer
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_clear(Layer *console_layer) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_data->pos         = 0;  // First chunk starts at the start of the buffer
+  console_data->buffer_used = 0;
+  console_data->chunk_first = 0;
+  console_data->chunk_count = 0;
+  console_data->redraw_full = true;
+  console_data->follow_tail = true;
+  console_layer_persist_schedule(console_data);
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  console_data->level       = ConsoleLayerLevelInfo;
+#endif
+
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  console_data->background_color = GColorInherit;
+  console_data->text_color       = GColorInherit;
+  console_data->font             = GFontInherit;
+  console_data->alignment        = GTextAlignmentInherit;
+  console_data->word_wrap        = WordWrapInherit;
+#endif
+
+  console_layer_mark_dirty(console_layer);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+// A chunk is written in two steps: its header goes in at pos, then once its text (and optional newline and the
+// terminating 0) have followed it, it's added to the index.  Room must already have been made for it.
+// In a batch, text with the same style as the newest chunk (on the same row) is added onto the end of it instead, as
+// another 0 terminated fragment sharing its header.  Fragments are drawn on top of each other, like separate chunks on
+// the same row would be.
+
+// Copies length bytes into the buffer at pos (in at most two pieces, either side of the end of the buffer) and moves pos past them
+static void console_layer_write_bytes(console_data_struct *console_data, const void *bytes, size_t length) {
+  size_t first_part = console_data->buffer_size - console_data->pos;
+  if(length <= first_part) {
+    memcpy(&console_data->buffer[console_data->pos], bytes, length);
+    console_data->pos += length;
+  } else {
+    memcpy(&console_data->buffer[console_data->pos], bytes, first_part);
+    memcpy(console_data->buffer, (const uint8_t*)bytes + first_part, length - first_part);
+    console_data->pos = length - first_part;
+  }
+}
+
+// Copies length bytes out of the buffer starting at index, which may wrap around the end of the buffer
+static void console_layer_read_bytes(console_data_struct *console_data, size_t index, void *bytes, size_t length) {
+  index %= console_data->buffer_size;
+  size_t first_part = console_data->buffer_size - index;
+  if(length <= first_part) {
+    memcpy(bytes, &console_data->buffer[index], length);
+  } else {
+    memcpy(bytes, &console_data->buffer[index], first_part);
+    memcpy((uint8_t*)bytes + first_part, console_data->buffer, length - first_part);
+  }
+}
+
+// Copies the text from begin to end into the buffer at pos, packed if compact, and moves pos past it.  Returns the bytes
+// it took up, which is never more than end - begin, so that's all the room it needs.
+static size_t console_layer_write_text_bytes(console_data_struct *console_data, const char *begin, const char *end, bool compact) {
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+  if(compact) {
+    uint8_t packed[32];
+    size_t length = 0, total = 0;
+    while(begin<end) {
+      packed[length++] = console_layer_compact_next(&begin, end);
+      if(length==sizeof(packed) || begin==end) {
+        console_layer_write_bytes(console_data, packed, length);
+        total += length;
+        length = 0;
+      }
+    }
+    return total;
+  }
+#endif
+  console_layer_write_bytes(console_data, begin, end - begin);
+  return end - begin;
+}
+
+// Builds a chunk's header (which may evict chunks to free up a style).  Returns its length.
+static size_t console_layer_make_header(console_data_struct *console_data, uint8_t *header, GBitmap *image, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap) {
+  size_t length = STYLE_BYTE_LENGTH;
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  header[0] = console_layer_intern_style(console_data, text_color, background_color, font, alignment, word_wrap) | (image?IMAGE_BIT:0);
+#elif !defined(CONSOLE_LAYER_NO_IMAGES)
+  header[0] = image?IMAGE_BIT:0;
+#endif
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  header[0] |= console_data->level << LEVEL_SHIFT;
+#endif
+
+#ifndef CONSOLE_LAYER_NO_IMAGES
+  // Pointers are stored as they are in memory
+  if(image) {
+    memcpy(&header[length], &image, sizeof(image));
+    length += sizeof(image);
+  }
+#endif
+
+  return length;
+}
+
+// Adds the chunk_length byte chunk just written (ending at pos) to the index
+static void console_layer_add_chunk(console_data_struct *console_data, size_t chunk_length, size_t header_length, bool measure, GFont font, bool word_wrap, GTextAlignment alignment) {
+  console_data->pos %= console_data->buffer_size;
+  console_chunk *chunk = &console_data->chunks[(console_data->chunk_first + console_data->chunk_count) % console_data->chunk_capacity];
+  chunk->offset = (console_data->pos + console_data->buffer_size - chunk_length) % console_data->buffer_size;
+  chunk->length = chunk_length;
+#ifndef CONSOLE_LAYER_NO_REPEATS
+  chunk->repeats = 0;
+#endif
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  chunk->seq     = console_data->chunk_seq;
+#endif
+  console_data->chunk_count++;
+  console_data->chunk_seq++;
+  console_data->buffer_used += chunk_length;
+  COUNT_STAT(console_data, chunks_written, 1);
+  COUNT_STAT(console_data, bytes_written, chunk_length);
+  console_layer_persist_touch_chunk(console_data, chunk, chunk->offset, chunk_length);
+
+  // Measure it while it's in hand.  If its text wraps around the end of the buffer, or the layer isn't on screen, it's left
+  // unmeasured and console_layer_update measures it the first time it's drawn.
+  size_t text_index = (chunk->offset + header_length) % console_data->buffer_size;
+  chunk->height = LAYOUT_UNMEASURED;
+  FORGET_ROUND_LAYOUT(chunk);
+  if(measure && text_index + (chunk_length - header_length) <= console_data->buffer_size)
+    console_layer_get_text_height(console_data, chunk, &console_data->buffer[text_index], chunk_length - header_length - 1, font, word_wrap, alignment, console_data->layout_width);
+}
+
+// Returns the newest chunk if, in a batch, a fragment_length byte fragment with this header can go onto the end of it:
+// it has to have exactly the same header (and no image) and not end in a newline, and the buffer has to fit both.
+static console_chunk* console_layer_get_extendable_chunk(console_data_struct *console_data, uint8_t *header, size_t header_length, size_t fragment_length) {
+  if(console_data->batch_depth==0 || console_data->chunk_count==0 || (header_length>0 && HAS_IMAGE(header[0])))
+    return NULL;
+  console_chunk *chunk = console_layer_get_chunk(console_data, console_data->chunk_count - 1);
+  if(chunk->length + fragment_length > console_data->buffer_size)
+    return NULL;
+  uint8_t chunk_header[MAX_HEADER_LENGTH + 1];  // (+1: it can be 0 long)
+  console_layer_read_bytes(console_data, chunk->offset, chunk_header, header_length);
+  if(memcmp(chunk_header, header, header_length))
+    return NULL;
+  if(console_layer_chunk_ends_row(console_data, console_data->chunk_count - 1))
+    return NULL;
+  return chunk;
+}
+
+// Makes room for a fragment_length byte fragment after the newest chunk
+static void console_layer_begin_extending_chunk(console_data_struct *console_data, size_t fragment_length) {
+  while(console_data->buffer_used + fragment_length > console_data->buffer_size)  // Never gets to the newest chunk
+    console_layer_evict_chunk(console_data);
+  if(console_data->drawn_seq == console_data->chunk_seq)  // Already on screen
+    console_data->redraw_full = true;
+}
+
+// Adds the fragment_length byte fragment just written (ending at pos) onto the newest chunk
+static void console_layer_extend_chunk(console_data_struct *console_data, console_chunk *chunk, size_t fragment_length, bool measure, GFont font, bool word_wrap, GTextAlignment alignment) {
+  console_data->pos %= console_data->buffer_size;
+  chunk->length += fragment_length;
+  console_data->buffer_used += fragment_length;
+  COUNT_STAT(console_data, bytes_written, fragment_length);
+  size_t fragment_index = (console_data->pos + console_data->buffer_size - fragment_length) % console_data->buffer_size;
+  console_layer_persist_touch_chunk(console_data, chunk, fragment_index, fragment_length);
+  FORGET_ROUND_LAYOUT(chunk);
+
+  // Measure just the new fragment, if it's in one piece and the rest of the chunk has been measured already (at the
+  // layer's width)
+  if(!measure || chunk->height == LAYOUT_UNMEASURED || fragment_index + fragment_length > console_data->buffer_size
+#ifdef PBL_ROUND
+     || (word_wrap && chunk->width_max != console_data->layout_width)
+#endif
+    ) {
+    chunk->height = LAYOUT_UNMEASURED;
+  } else if(word_wrap) {
+    GSize size = console_layer_measure_text(console_data, &console_data->buffer[fragment_index], font, word_wrap, alignment, console_data->layout_width);
+    if(size.h > chunk->height) chunk->height = size.h;
+#ifdef PBL_ROUND
+    if(size.w > chunk->width_min) chunk->width_min = size.w;
+#endif
+  }
+}
+
+#ifndef CONSOLE_LAYER_NO_REPEATS
+// Whether a chunk with this header and text (from begin to end, then a newline) would be exactly the newest chunk over
+// again.  Text is packed (if compact) as it's compared, and has to end right where the newest chunk's does.  Only a
+// newest chunk that fits in the buffer twice is compared, so text formatted straight into the buffer can't have
+// overwritten it.
+static bool console_layer_is_repeat(console_data_struct *console_data, uint8_t *header, size_t header_length, const char *begin, const char *end, bool compact) {
+  if(!console_data->collapse_repeats || console_data->chunk_count==0)
+    return false;
+  console_chunk *chunk = console_layer_get_chunk(console_data, console_data->chunk_count - 1);
+  if(2 * chunk->length > console_data->buffer_size || chunk->length < header_length + 2)
+    return false;
+  size_t text_length = chunk->length - header_length - 2;  // (less the newline and terminating 0)
+
+  uint8_t *buffer = (uint8_t*)console_data->buffer;
+  size_t   index  = chunk->offset;
+  for(size_t i=0; i<header_length; i++) {
+    if(buffer[index] != header[i])
+      return false;
+    if(++index == console_data->buffer_size) index = 0;
+  }
+  for(; begin<end; text_length--) {
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+    uint8_t c = compact ? console_layer_compact_next(&begin, end) : (uint8_t)*begin++;
+#else
+    uint8_t c = *begin++;
+#endif
+    if(text_length==0 || buffer[index] != c)
+      return false;
+    if(++index == console_data->buffer_size) index = 0;
+  }
+  return text_length==0 && buffer[index]==10;  // (then the terminating 0, going by the length)
+}
+
+// Counts the newest chunk once more instead of writing it again
+static void console_layer_repeat_chunk(console_data_struct *console_data) {
+  console_chunk *chunk = console_layer_get_chunk(console_data, console_data->chunk_count - 1);
+  if(chunk->repeats < UINT16_MAX)
+    chunk->repeats++;
+  chunk->height = LAYOUT_UNMEASURED;  // The count might not fit on the end of its last line
+  FORGET_ROUND_LAYOUT(chunk);
+  COUNT_STAT(console_data, chunks_repeated, 1);
+  console_layer_persist_touch(console_data, (chunk - console_data->chunks) * sizeof(console_chunk), sizeof(console_chunk));
+}
+
+// Puts a repeated chunk's count (" ×N") in count, which needs room for 10 bytes.  Returns its length (0 if it's not repeated).
+static size_t console_layer_get_repeat_text(console_chunk *chunk, char *count) {
+  return chunk->repeats ? (size_t)snprintf(count, 10, " \xC3\x97%u", (unsigned)chunk->repeats + 1) : 0;
+}
+#endif
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_write_text_and_image_styled(Layer *console_layer, GBitmap *image, char *text, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap, bool advance) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+#ifdef CONSOLE_LAYER_NO_IMAGES
+  image = NULL;
+#endif
+#ifdef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  font = GFontInherit; alignment = GTextAlignmentInherit; word_wrap = WordWrapInherit;  // Laid out in the layer's style
+#endif
+
+  // Settings the new chunks will be laid out with, so they can be measured now instead of in console_layer_update
+  console_layer_check_layout_cache(console_data, console_layer_get_text_width(console_layer));
+  bool           measure          = console_layer_is_visible(console_layer);
+  GFont          layout_font      = font ? font : console_data->layer_font;
+  bool           layout_word_wrap = word_wrap&WORD_WRAP_INHERIT_BIT ? console_data->layer_word_wrap : word_wrap&WORD_WRAP_BIT;
+  GTextAlignment layout_alignment = alignment==GTextAlignmentLeft || alignment==GTextAlignmentCenter || alignment==GTextAlignmentRight ? alignment : console_data->layer_alignment;
+
+  // Copy text to buffer, one chunk per line
+  char *begin, *end;
+  uint8_t header[MAX_HEADER_LENGTH + 1];  // (+1: it can be 0 long)
+  while(*text || image) {
+    // Adding feature: Draw text on top of image
+    begin = text;
+    if(image) {
+      while(*text) text++;   // ends on 0
+    } else {
+      while((*text) && ((*text)!=10)) text++;   // ends on 0 or 10 (newline)
+    }
+    end = text;
+    bool newline = (*text==10) || advance;
+    if(*text==10) text++; // skip past 10
+    
+    size_t header_length = console_layer_make_header(console_data, header, image, text_color, background_color, font, alignment, word_wrap);
+    image = NULL;  // to exit the while loop above
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+    if(console_data->compact_text && console_layer_can_compact(begin, end))
+      header[0] |= COMPACT_BIT;
+#endif
+    bool compact = IS_COMPACT(header[0]);  // Packed text is measured when it's first drawn, once it's been unpacked
+
+    // In a batch, carry on the newest chunk if it's the same style.  Room is made for the text unpacked, which is as
+    // long as it can be, so packed text is only gone through once, as it's written.
+    size_t fragment_length = (end - begin) + (newline?1:0) + 1;
+    console_chunk *chunk = console_layer_get_extendable_chunk(console_data, header, header_length, fragment_length);
+    if(chunk) {
+      console_layer_begin_extending_chunk(console_data, fragment_length);
+      fragment_length = console_layer_write_text_bytes(console_data, begin, end, compact) + (newline?1:0) + 1;
+      console_layer_write_bytes(console_data, newline ? "\n" : "", newline ? 2 : 1);  // 10 if writeln, then 0
+      console_layer_extend_chunk(console_data, chunk, fragment_length, measure && !compact, layout_font, layout_word_wrap, layout_alignment);
+      continue;
+    }
+    
+    // Work out the chunk's size (at most, if it's packed) so whole chunks can be evicted to make room for it
+    size_t chunk_length  = header_length + (end - begin) + (newline?1:0) + 1;
+    if(chunk_length > console_data->buffer_size) {
+      // Chunks bigger than the whole buffer are cut short (without splitting a UTF-8 character).  Packed text is cut to
+      // the same length, so it always fits the scratch buffer once it's unpacked.
+      size_t overflow = chunk_length - console_data->buffer_size;
+      end = (size_t)(end - begin) > overflow ? end - overflow : begin;
+      while(end>begin && (*end & 0xC0)==0x80) end--;
+      chunk_length = header_length + (end - begin) + (newline?1:0) + 1;
+      if(chunk_length > console_data->buffer_size) break;  // Buffer's too small for even the header
+    }
+#ifndef CONSOLE_LAYER_NO_REPEATS
+    if(newline && console_layer_is_repeat(console_data, header, header_length, begin, end, compact)) {
+      console_layer_repeat_chunk(console_data);
+      continue;
+    }
+#endif
+    console_layer_make_room(console_data, chunk_length);
+    console_layer_write_bytes(console_data, header, header_length);
+
+    // Copy string to buffer
+    chunk_length = header_length + console_layer_write_text_bytes(console_data, begin, end, compact) + (newline?1:0) + 1;
+
+    // 10 if writeln, then 0 no matter if 10 or 0
+    console_layer_write_bytes(console_data, newline ? "\n" : "", newline ? 2 : 1);
+
+    console_layer_add_chunk(console_data, chunk_length, header_length, measure && !compact, layout_font, layout_word_wrap, layout_alignment);
+  }
+
+  console_layer_wrote(console_layer);
+  console_layer_mark_dirty(console_layer);
+}
+
+#ifndef CONSOLE_LAYER_NO_IMAGES
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_write_text_and_image(Layer *console_layer, GBitmap *image, char *text) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_layer_write_text_and_image_styled(console_layer, image, text, WRITE_STYLE(console_data), false);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_writeln_text_and_image(Layer *console_layer, GBitmap *image, char *text) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_layer_write_text_and_image_styled(console_layer, image, text, WRITE_STYLE(console_data), true);
+}
+#endif
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_write_text_styled(Layer *console_layer, char *text, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap, bool advance) {
+  console_layer_write_text_and_image_styled(console_layer, NULL_IMAGE, text, text_color, background_color, font, alignment, word_wrap, advance);
+}
+
+#ifndef CONSOLE_LAYER_NO_IMAGES
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_write_image_styled(Layer *console_layer, GBitmap *image, GColor background_color, GTextAlignment alignment, bool advance) {
+  if(image)
+    console_layer_write_text_and_image_styled(console_layer, image, " ", GColorInherit, background_color, GFontInherit, alignment, WordWrapFalse, advance);
+}
+#endif
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_write_text(Layer *console_layer, char *text) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_layer_write_text_and_image_styled(console_layer, NULL_IMAGE, text, WRITE_STYLE(console_data), false);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_writeln_text(Layer *console_layer, char *text) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_layer_write_text_and_image_styled(console_layer, NULL_IMAGE, text, WRITE_STYLE(console_data), true);
+}
+
+#ifndef CONSOLE_LAYER_NO_IMAGES
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_write_image(Layer *console_layer, GBitmap *image) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_layer_write_image_styled(console_layer, image, WRITE_IMAGE_STYLE(console_data), false);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_writeln_image(Layer *console_layer, GBitmap *image) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_layer_write_image_styled(console_layer, image, WRITE_IMAGE_STYLE(console_data), true);
+}
+#endif
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Whether text is formatted into the scratch buffer and written from there, rather than straight into the buffer:
+// packed text has to be packed on its way in, and evicting around kept chunks moves chunks that text formatted in
+// place could have written over
+static bool console_layer_formats_in_scratch(console_data_struct *console_data) {
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+  if(console_data->compact_text)
+    return true;
+#endif
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  if(console_data->keep_level > ConsoleLayerLevelDebug)
+    return true;
+#endif
+  return false;
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Formatted text goes straight into the buffer, just after where its chunk's header will go.  That only works if it
+// doesn't run past the end of the buffer and is only one line: otherwise it's formatted into the scratch buffer and
+// written like any other text (cut short to the size of the buffer).
+void console_layer_vprintf_styled(Layer *console_layer, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap, bool advance, const char *format, va_list args) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(console_layer_formats_in_scratch(console_data)) {
+    COUNT_STAT(console_data, scratch_allocs, 1);
+    if(vsnprintf(console_data->scratch, console_data->buffer_size, format, args) > 0)
+      console_layer_write_text_styled(console_layer, console_data->scratch, text_color, background_color, font, alignment, word_wrap, advance);
+    return;
+  }
+  console_layer_check_layout_cache(console_data, console_layer_get_text_width(console_layer));
+#ifdef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  font = GFontInherit; alignment = GTextAlignmentInherit; word_wrap = WordWrapInherit;  // Laid out in the layer's style
+#endif
+
+  uint8_t header[MAX_HEADER_LENGTH + 1];  // (+1: it can be 0 long)
+  size_t header_length = console_layer_make_header(console_data, header, NULL_IMAGE, text_color, background_color, font, alignment, word_wrap);
+  console_chunk *chunk = console_layer_get_extendable_chunk(console_data, header, header_length, 0);
+
+  // Text goes at pos if it's carrying on the newest chunk, otherwise just after the new chunk's header
+  size_t text_index = (console_data->pos + (chunk ? 0 : header_length)) % console_data->buffer_size;
+  size_t room       = console_data->buffer_size - text_index;  // Bytes until the end of the buffer
+
+  // Anything this overwrites is evicted below, whether the text stays in place or not (unless there's no text)
+  va_list retry;
+  va_copy(retry, args);
+  char first_byte = console_data->buffer[text_index];
+  int text_length = vsnprintf(&console_data->buffer[text_index], room, format, args);
+  if(text_length<=0)
+    console_data->buffer[text_index] = first_byte;
+  size_t fragment_length = text_length + (advance?1:0) + 1;
+  bool   in_place        = text_length>0 && fragment_length <= room && !memchr(&console_data->buffer[text_index], 10, text_length) &&
+                           (!chunk || chunk->length + fragment_length <= console_data->buffer_size);
+
+#ifndef CONSOLE_LAYER_NO_REPEATS
+  if(in_place && !chunk && advance &&
+     console_layer_is_repeat(console_data, header, header_length, &console_data->buffer[text_index], &console_data->buffer[text_index + text_length], false)) {
+    while(console_data->buffer_used + header_length + fragment_length > console_data->buffer_size)  // Whatever the text overwrote
+      console_layer_evict_chunk(console_data);
+    console_layer_repeat_chunk(console_data);
+    console_layer_wrote(console_layer);
+    console_layer_mark_dirty(console_layer);
+  } else
+#endif
+  if(in_place) {
+    if(chunk) {
+      console_layer_begin_extending_chunk(console_data, fragment_length);
+    } else {
+      console_layer_make_room(console_data, header_length + fragment_length);
+      console_layer_write_bytes(console_data, header, header_length);
+    }
+    console_data->pos = text_index + text_length;
+    console_layer_write_bytes(console_data, advance ? "\n" : "", advance ? 2 : 1);
+
+    bool           measure          = console_layer_is_visible(console_layer);
+    GFont          layout_font      = font ? font : console_data->layer_font;
+    bool           layout_word_wrap = word_wrap&WORD_WRAP_INHERIT_BIT ? console_data->layer_word_wrap : word_wrap&WORD_WRAP_BIT;
+    GTextAlignment layout_alignment = alignment==GTextAlignmentLeft || alignment==GTextAlignmentCenter || alignment==GTextAlignmentRight ? alignment : console_data->layer_alignment;
+    if(chunk)
+      console_layer_extend_chunk(console_data, chunk, fragment_length, measure, layout_font, layout_word_wrap, layout_alignment);
+    else
+      console_layer_add_chunk(console_data, header_length + fragment_length, header_length, measure, layout_font, layout_word_wrap, layout_alignment);
+    console_layer_wrote(console_layer);
+    console_layer_mark_dirty(console_layer);
+  } else if(text_length>0) {
+    // The text has already gone over whatever it ran into, and writing it again mightn't store over all of that (it
+    // could turn out to be a repeat), so the chunks it ran into go now
+    size_t written = (text_index + console_data->buffer_size - console_data->pos) % console_data->buffer_size + ((size_t)text_length < room ? (size_t)text_length + 1 : room);
+    while(console_data->chunk_count>0 && console_data->buffer_used + written > console_data->buffer_size)
+      console_layer_evict_chunk(console_data);
+    COUNT_STAT(console_data, scratch_allocs, 1);
+    vsnprintf(console_data->scratch, console_data->buffer_size, format, retry);
+    console_layer_write_text_styled(console_layer, console_data->scratch, text_color, background_color, font, alignment, word_wrap, advance);
+  }
+  va_end(retry);
+}
+
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_printf_styled(Layer *console_layer, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap, bool advance, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  console_layer_vprintf_styled(console_layer, text_color, background_color, font, alignment, word_wrap, advance, format, args);
+  va_end(args);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_vprintf(Layer *console_layer, const char *format, va_list args) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_layer_vprintf_styled(console_layer, WRITE_STYLE(console_data), false, format, args);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_vprintfln(Layer *console_layer, const char *format, va_list args) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_layer_vprintf_styled(console_layer, WRITE_STYLE(console_data), true, format, args);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_printf(Layer *console_layer, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  console_layer_vprintf(console_layer, format, args);
+  va_end(args);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_printfln(Layer *console_layer, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  console_layer_vprintfln(console_layer, format, args);
+  va_end(args);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+
+
+
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Draw Layer
+// ------------------------------------------------------------------------------------------------------------ //
+#ifndef CONSOLE_LAYER_NO_FIND
+// A highlighted chunk's text is drawn in its background color, or the layer's if it doesn't have one, or if that's
+// clear too, whichever of black and white stands out from its text color
+static GColor console_layer_get_highlight_text_color(console_data_struct *console_data, GColor background_color, GColor text_color) {
+  if(background_color.argb != GColorClear.argb)
+    return background_color;
+  if(console_data->layer_background_color.argb != GColorClear.argb)
+    return console_data->layer_background_color;
+  return gcolor_equal(text_color, GColorWhite) ? GColorBlack : GColorWhite;
+}
+
+#ifndef CONSOLE_LAYER_NO_MONO_FONT
+// Draws the highlighted match over a chunk's mono text, laid out in box like console_layer_draw_mono_text lays it out:
+// each line's part of it gets color behind it and is drawn again on top in highlight_color
+static void console_layer_draw_mono_match(console_data_struct *console_data, GContext *ctx, const char *text, size_t text_length, bool word_wrap, GRect box, GTextAlignment alignment, GColor color, GColor highlight_color) {
+  const char *match = text + console_data->highlight.index, *match_end = match + console_data->highlight.length;
+  if(console_data->highlight.index + console_data->highlight.length > text_length)
+    return;
+  const char *line = text;  // Start of the fragment it's in (every fragment is drawn in the same place)
+  while(line + strlen(line) < match)
+    line += strlen(line) + 1;
+
+  int16_t columns = box.size.w / MONO_GLYPH_WIDTH;
+  const char *end, *next;
+  for(int16_t top = box.origin.y; line && line < match_end; top += MONO_LINE_HEIGHT, line = next) {
+    int16_t length = console_layer_mono_line(line, columns, word_wrap, &end, &next);
+    int16_t before = 0, count = 0;  // Characters on the line before the match, and of it
+    for(const char *c = line; c < end; ) {
+      const char *at = c;
+      console_layer_mono_glyph(&c);
+      if(at < match)          before++;
+      else if(at < match_end) count++;
+    }
+    if(count == 0)
+      continue;
+    int16_t left = box.origin.x;
+    switch (alignment) {
+      case GTextAlignmentCenter: left += (box.size.w - length * MONO_GLYPH_WIDTH) / 2; break;
+      case GTextAlignmentRight:  left +=  box.size.w - length * MONO_GLYPH_WIDTH;      break;
+      default: break;
+    }
+    GRect rect = GRect(left + before * MONO_GLYPH_WIDTH, top, count * MONO_GLYPH_WIDTH, MONO_LINE_HEIGHT);
+    graphics_context_set_fill_color(ctx, color);
+    graphics_fill_rect(ctx, rect, 0, GCornerNone);
+    const char *from = line;
+    while(before-- > 0)
+      console_layer_mono_glyph(&from);
+    console_layer_draw_mono_text(console_data, ctx, from, false, rect, GTextAlignmentLeft, highlight_color);
+  }
+}
+#endif
+#endif
+
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+static bool console_layer_draw_cached_row(console_data_struct *console_data, GContext *ctx, GRect bounds, GRect margin_bounds, uint16_t n, uint16_t stop_n, int16_t bottom, uint16_t *first_n, int16_t *height);
+static void console_layer_cache_row(console_data_struct *console_data, GContext *ctx, GRect bounds, GRect margin_bounds, uint16_t first_n, uint16_t n, int16_t bottom, int16_t height);
+#endif
+
+// Lays out rows bottom-up from the bottom of margin_bounds, from chunk start_n - 1 back to (but not including) chunk
+// stop_n, or until the rows go past the top.  Nothing is drawn if ctx is NULL, which is used to work out how tall the
+// newest rows are.  Returns the y (relative to margin_bounds, like the rows) of the top of the last row laid out, and
+// the oldest chunk laid out in last_n (if not NULL).
+static int16_t console_layer_draw_rows(console_data_struct *console_data, GContext *ctx, GRect bounds, GRect margin_bounds, uint16_t start_n, uint16_t stop_n, uint16_t *last_n) {
+  // Display Rows
+  int16_t y = margin_bounds.size.h; // Start at the bottom
+  int16_t row_height = 0;    // row_height = tallest font on the row
+   
+  // Start at the newest chunk to draw
+  uint16_t n = start_n;
+  
+  // Make advance=true so if bounds.size.h==0 it will just quit
+  bool advance = true;
+
+#ifdef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  // Everything's in the layer's style (and its background is already painted)
+  bool           word_wrap        = console_data->layer_word_wrap;
+  GTextAlignment alignment        = console_data->layer_alignment;
+  GColor         background_color = GColorClear;
+  GFont          font             = console_data->layer_font;
+  GColor         text_color       = console_data->layer_text_color;
+  if(ctx) graphics_context_set_text_color(ctx, text_color);
+#else
+  // Style of the chunk before, so runs of chunks in the same style don't have to be decoded again
+  uint8_t style_id = NO_STYLE;
+  bool word_wrap = false;
+  GTextAlignment alignment = GTextAlignmentLeft;
+  GColor background_color = GColorClear;
+  GColor text_color = GColorClear;
+  GFont font = NULL;
+#endif
+
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  bool hidden_row_end = false;  // A chunk left out since the last one drawn ended a row
+#endif
+
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+  // Row being drawn, to go in the row cache once it's finished: its newest chunk + 1 (0 = none), and its oldest so far
+  console_row_cache *row_cache = ctx && console_data->row_cache && console_data->row_cache->clip.size.h > 0 ? console_data->row_cache : NULL;
+  uint16_t row_end_n = 0, row_first_n = 0;
+#endif
+
+#ifdef PBL_ROUND
+  // Rows start above the bottom of the screen where it's too narrow for one
+  for(int16_t x; console_data->round_layout && y > 0 && console_layer_get_round_chord(console_data, y - 1, y, &x) < CONSOLE_LAYER_ROUND_MIN_WIDTH; )
+    y--;
+#endif
+
+  // adding "|| !advance" so all text in multiple-text-segments-on-one-row which are half cutoff by the top border are all displayed
+  while ((y>margin_bounds.origin.y || !advance) && n>stop_n) {  // While text is within visible bounds && not past the oldest chunk
+    console_chunk *chunk = console_layer_get_chunk(console_data, --n);
+    
+    // First thing is the Style
+    uint8_t settings = console_layer_get_style_byte(console_data, chunk);
+#ifndef CONSOLE_LAYER_NO_LEVELS
+    if(GET_LEVEL(settings) < console_data->view_level) {  // Left out without being read any further
+      hidden_row_end |= console_layer_chunk_ends_row(console_data, n);
+      continue;
+    }
+#endif
+    advance = console_layer_chunk_ends_row(console_data, n);      // If it ends in a 10 (newline), advance
+#ifndef CONSOLE_LAYER_NO_LEVELS
+    advance |= hidden_row_end;
+    hidden_row_end = false;
+#endif
+
+    // Advance or not -- advance means moving text drawing to the next row up
+    if (advance) {
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+      if(row_end_n)  // The row below is finished
+        console_layer_cache_row(console_data, ctx, bounds, margin_bounds, row_first_n, row_end_n - 1, y, row_height);
+      row_end_n = 0;
+#endif
+      y -= row_height;
+      row_height = 0;
+    }
+    int16_t row_x = 0, row_width = margin_bounds.size.w;  // Where the row goes across margin_bounds
+#ifdef PBL_ROUND
+    if(console_data->round_layout && (advance || n == start_n - 1) && console_layer_get_round_chord(console_data, y - 1, y, &row_x) < CONSOLE_LAYER_ROUND_MIN_WIDTH) {
+      n++;  // No room for a row here (or above, the screen only gets narrower)
+      break;
+    }
+#endif
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+    if(row_cache && (advance || !row_end_n)) {  // First chunk of a row: copy it back if it's in the cache
+      uint16_t first_n;
+      if(console_layer_draw_cached_row(console_data, ctx, bounds, margin_bounds, n, stop_n, y, &first_n, &row_height)) {
+        COUNT_STAT(console_data, rows_cached, 1);
+        advance &= first_n == n;  // (as it would be after drawing the row's oldest chunk)
+        n = first_n;
+        continue;
+      }
+      row_end_n = n + 1;
+    }
+    row_first_n = n;
+#endif
+    if(ctx && (advance || n == start_n - 1))
+      COUNT_STAT(console_data, rows_drawn, 1);
+
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+    if((settings&STYLE_ID_BITS) != style_id) {
+      style_id = settings&STYLE_ID_BITS;
+      console_style *style = &console_data->styles[style_id];
+
+      word_wrap = style->settings&WORD_WRAP_INHERIT_BIT ? console_data->layer_word_wrap : style->settings&WORD_WRAP_BIT;
+
+      // This could be quicker if I could just assume the enum: GTextAlignmentLeft=0, Center=1 and Right=2 (which it does.)  But I can't cause it'd lose abstraction.
+      switch (style->settings & ALIGNMENT_BITS) {
+        case 0b0000: alignment = GTextAlignmentLeft;   break;
+        case 0b0100: alignment = GTextAlignmentCenter; break;
+        case 0b1000: alignment = GTextAlignmentRight;  break;
+        default:     alignment = console_data->layer_alignment;
+      }
+
+      background_color = style->background_color.argb ? style->background_color : console_data->layer_background_color;  // Clear = inherit from layer
+      font             = style->font                  ? style->font             : console_data->layer_font;
+      text_color       = style->text_color.argb       ? style->text_color       : console_data->layer_text_color;
+      if(ctx) graphics_context_set_text_color(ctx, text_color);
+    }
+#endif
+
+    GRect rect = GRectZero;
+    GBitmap *image = NULL;
+    if(HAS_IMAGE(settings))  // Read image (NULL if it didn't survive being restored)
+      console_layer_read_bytes(console_data, chunk->offset + STYLE_BYTE_LENGTH, &image, sizeof(image));
+    if(image)
+      rect.size = gbitmap_get_bounds(image).size;
+
+    // Text runs from just after the header to the end of the chunk.  Pebble's text functions can't wrap around the end of
+    // the buffer, so text is drawn straight out of the buffer unless it straddles the end, in which case it's stitched
+    // together in the scratch buffer.
+    size_t header_length = console_layer_get_header_length(settings);
+    size_t text_index    = (chunk->offset + header_length) % console_data->buffer_size;
+    size_t text_length   = chunk->length - header_length - 1;  // Not counting the terminating 0
+    char  *text          = &console_data->buffer[text_index];
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+    if(IS_COMPACT(settings)) {  // Packed text is unpacked (the chunks on screen only)
+      COUNT_STAT(console_data, scratch_allocs, 1);
+      text_length = console_layer_expand_text(console_data, text_index, text_length, console_data->scratch, console_data->buffer_size);
+      text = console_data->scratch;
+    } else
+#endif
+    if(text_index + text_length >= console_data->buffer_size) {
+      COUNT_STAT(console_data, scratch_allocs, 1);
+      console_layer_read_bytes(console_data, text_index, console_data->scratch, text_length);
+      console_data->scratch[text_length] = 0;
+      text = console_data->scratch;
+    }
+#ifndef CONSOLE_LAYER_NO_REPEATS
+    char count[10];
+    size_t count_length = console_layer_get_repeat_text(chunk, count);
+    if(count_length && count_length + 2 <= console_data->buffer_size) {  // The count goes on the end of the line, before its newline
+      size_t line_length = text_length - 1;
+      if(line_length + count_length + 2 > console_data->buffer_size) {
+        line_length = console_data->buffer_size - count_length - 2;
+        while(line_length>0 && (text[line_length] & 0xC0)==0x80) line_length--;  // (not splitting a UTF-8 character)
+      }
+      if(text != console_data->scratch)
+        COUNT_STAT(console_data, scratch_allocs, 1);
+      memmove(console_data->scratch, text, line_length);
+      memcpy(&console_data->scratch[line_length], count, count_length);
+      memcpy(&console_data->scratch[line_length + count_length], "\n", 2);
+      text = console_data->scratch;
+      text_length = line_length + count_length + 1;
+    }
+#endif
+
+    // Draw the row background, if there is one
+    // Calculate row height, draw the background if it has changed
+    // object_height = height of current text to draw or height of image to draw
+    // row_height = height of tallest text drawn on same row (without advance, e.g. without writeln())
+#ifdef PBL_ROUND
+    int16_t text_height = console_data->round_layout ? console_layer_get_round_text_height(console_data, chunk, text, text_length, font, word_wrap, alignment, y, row_height, &row_x, &row_width)
+                                                     : console_layer_get_text_height(console_data, chunk, text, text_length, font, word_wrap, alignment, console_data->layout_width);
+#else
+    int16_t text_height = console_layer_get_text_height(console_data, chunk, text, text_length, font, word_wrap, alignment, console_data->layout_width);
+#endif
+    int16_t object_height = rect.size.h>text_height ? rect.size.h : text_height; // Height of the current image/text being drawn is the max of the two
+    if(object_height>row_height) {
+      if(ctx && background_color.argb!=GColorClear.argb) {
+        graphics_context_set_fill_color(ctx, background_color);
+        graphics_fill_rect(ctx, GRect(bounds.origin.x, bounds.origin.y + y - object_height, bounds.size.w, object_height - row_height), 0, GCornerNone);  // fill background (or horizontal sliver if difference in font height or multi-line height)
+      }
+      row_height = object_height;
+    }
+
+    if(!ctx) continue;  // Just laying out
+
+    // Draw the image
+    if(image) {
+      switch (alignment) {
+        case GTextAlignmentCenter: rect.origin.x = row_x + (row_width - rect.size.w) / 2; break;
+        case GTextAlignmentRight:  rect.origin.x = row_x + (row_width - rect.size.w)    ; break;
+        default:                   rect.origin.x = row_x;
+      }
+      graphics_context_set_compositing_mode(ctx, GCompOpSet);
+      graphics_draw_bitmap_in_rect(ctx, image, GRect(margin_bounds.origin.x + rect.origin.x, margin_bounds.origin.y + y - rect.size.h, rect.size.w, rect.size.h));
+    }
+    GColor draw_color = text_color;
+    GRect  text_box   = GRect(margin_bounds.origin.x + row_x, margin_bounds.origin.y + y - text_height, row_width, text_height);  // align-bottom
+#ifndef CONSOLE_LAYER_NO_FIND
+    // The match is drawn the other way round: its text color behind it, its text in its background color.  Mono text is
+    // laid out here, so that's just the match; Pebble doesn't say where other fonts put each character, so it's the
+    // whole chunk with the match in.
+    bool   highlighted     = console_data->highlight.length>0 && console_data->highlight.seq == console_layer_get_chunk_seq(console_data, n);
+    GColor highlight_color = highlighted ? console_layer_get_highlight_text_color(console_data, background_color, text_color) : text_color;
+#ifndef CONSOLE_LAYER_NO_MONO_FONT
+    bool   highlight_match = highlighted && font == CONSOLE_LAYER_FONT_MONO;
+#else
+    bool   highlight_match = false;
+#endif
+    if(highlighted && !highlight_match) {
+      graphics_context_set_fill_color(ctx, text_color);
+      graphics_fill_rect(ctx, text_box, 0, GCornerNone);
+      draw_color = highlight_color;
+      graphics_context_set_text_color(ctx, draw_color);
+    }
+#endif
+    // Render Text, every fragment in the same place
+    for(char *fragment = text; fragment < text + text_length || fragment == text; fragment += strlen(fragment) + 1)
+      console_layer_draw_text(console_data, ctx, fragment, font, word_wrap, text_box, alignment, draw_color);
+#ifndef CONSOLE_LAYER_NO_FIND
+#ifndef CONSOLE_LAYER_NO_MONO_FONT
+    if(highlight_match)
+      console_layer_draw_mono_match(console_data, ctx, text, text_length, word_wrap, text_box, alignment, text_color, highlight_color);
+    else
+#endif
+    if(highlighted)
+      graphics_context_set_text_color(ctx, text_color);
+#endif
+    //graphics_draw_text(ctx, text, font, GRect(margin_bounds.origin.x, margin_bounds.origin.y + (y-3) - row_height,  margin_bounds.size.w, row_height ), GTextOverflowModeTrailingEllipsis, alignment, NULL);  // align-top
+  } // END While
+
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+  if(row_end_n && n == stop_n && (n == 0 || console_layer_chunk_ends_row(console_data, n - 1)))  // The top row's finished too
+    console_layer_cache_row(console_data, ctx, bounds, margin_bounds, row_first_n, row_end_n - 1, y, row_height);
+#endif
+  if(last_n) *last_n = n;
+  return y - row_height;
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Incremental Redraw
+// ------------------------------------------------------------------------------------------------------------ //
+// When the only change since the last frame is newly written rows, the rows already on screen are moved up in the
+// frame buffer and only the new rows are drawn.  A checksum of the rows area taken at the end of the last frame is
+// checked first: if anything else has drawn over the layer since (the window behind it, another layer on top, another
+// window), the whole layer is repainted instead.
+
+// Hash of every layer, header and border setting (everything in the struct before the write style)
+#ifdef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  #define LAYER_SETTINGS_END offsetof(console_data_struct, layout_width)
+#else
+  #define LAYER_SETTINGS_END offsetof(console_data_struct, word_wrap)
+#endif
+static uint32_t console_layer_get_style_hash(console_data_struct *console_data) {
+  uint32_t hash = 2166136261u;  // FNV-1a
+  for(size_t i=0; i<LAYER_SETTINGS_END; i++)
+    hash = (hash ^ ((uint8_t*)console_data)[i]) * 16777619u;
+  return hash;
+}
+
+// Gets the first and last column of frame buffer row y inside rect, clipped to the row (rows on round displays are shorter)
+static bool console_layer_get_row_span(GBitmap *frame_buffer, GRect rect, int16_t y, GBitmapDataRowInfo *info, int16_t *x0, int16_t *x1) {
+  *info = gbitmap_get_data_row_info(frame_buffer, y);
+  *x0 = rect.origin.x > info->min_x ? rect.origin.x : info->min_x;
+  *x1 = rect.origin.x + rect.size.w - 1 < info->max_x ? rect.origin.x + rect.size.w - 1 : info->max_x;
+  return *x0 <= *x1;
+}
+
+// Checksum of the pixels inside rect (screen coordinates)
+static uint32_t console_layer_checksum_pixels(GBitmap *frame_buffer, GRect rect) {
+  bool bits = gbitmap_get_format(frame_buffer) == GBitmapFormat1Bit;
+  uint32_t sum = 0;
+  GBitmapDataRowInfo info;
+  int16_t x0, x1;
+  for(int16_t y=rect.origin.y; y<rect.origin.y + rect.size.h; y++)
+    if(console_layer_get_row_span(frame_buffer, rect, y, &info, &x0, &x1)) {
+      if(bits) {x0 /= 8; x1 /= 8;}  // Whole bytes, so a neighbour's pixels in the edge bytes just cost a full repaint
+      for(int16_t x=x0; x<=x1; x++)
+        sum = ((sum << 1) | (sum >> 31)) + info.data[x];
+    }
+  return sum;
+}
+
+// Copies pixels x0 to x1 (inclusive) from one frame buffer row to another
+static void console_layer_copy_pixels(bool bits, uint8_t *dst, uint8_t *src, int16_t x0, int16_t x1) {
+  if(!bits) {
+    memcpy(dst + x0, src + x0, x1 - x0 + 1);
+    return;
+  }
+
+  // 1 bit per pixel, leftmost pixel in the lowest bit
+  int16_t first = x0 / 8, last = x1 / 8;
+  uint8_t first_mask = 0xFF << (x0 % 8), last_mask = 0xFF >> (7 - x1 % 8);
+  if(first == last) {
+    first_mask &= last_mask;
+    dst[first] = (dst[first] & ~first_mask) | (src[first] & first_mask);
+    return;
+  }
+  dst[first] = (dst[first] & ~first_mask) | (src[first] & first_mask);
+  memcpy(dst + first + 1, src + first + 1, last - first - 1);
+  dst[last]  = (dst[last]  & ~last_mask)  | (src[last]  & last_mask);
+}
+
+// Moves the pixels inside rect (screen coordinates) up by delta rows.  Where a row is wider than the one it's copied
+// from (the bottom half of a round display), the pixels with nothing to copy are filled with fill.
+static bool console_layer_scroll_pixels(GBitmap *frame_buffer, GRect rect, int16_t delta, GColor fill) {
+  GBitmapFormat format = gbitmap_get_format(frame_buffer);
+  if(format!=GBitmapFormat1Bit && format!=GBitmapFormat8Bit && format!=GBitmapFormat8BitCircular)
+    return false;
+  bool bits = format == GBitmapFormat1Bit;
+
+  GBitmapDataRowInfo dst, src;
+  int16_t x0, x1, src_x0, src_x1;
+  for(int16_t y=rect.origin.y; y<rect.origin.y + rect.size.h - delta; y++) {
+    if(!console_layer_get_row_span(frame_buffer, rect, y, &dst, &x0, &x1))
+      continue;
+    if(!console_layer_get_row_span(frame_buffer, rect, y + delta, &src, &src_x0, &src_x1)) {
+      src_x0 = x1 + 1;  // Nothing to copy
+      src_x1 = x1;
+    }
+    if(src_x0 < x0) src_x0 = x0;
+    if(src_x1 > x1) src_x1 = x1;
+    if(src_x0 <= src_x1)
+      console_layer_copy_pixels(bits, dst.data, src.data, src_x0, src_x1);
+    if(!bits) {  // 1 bit displays are rectangular, so only 8 bit rows can need filling
+      if(src_x0 > x0) memset(dst.data + x0,         fill.argb, src_x0 - x0);
+      if(src_x1 < x1) memset(dst.data + src_x1 + 1, fill.argb, x1 - src_x1);
+    }
+  }
+  return true;
+}
+
+// Area the rows are drawn in, below the header and the line under it (layer coordinates)
+static GRect console_layer_get_rows_rect(console_data_struct *console_data, GRect bounds, GRect margin_bounds, int16_t header_height) {
+  int16_t top = bounds.origin.y + header_height;
+#ifndef CONSOLE_LAYER_NO_BORDER
+  if(header_height>0 && console_data->border_enabled && console_data->border_thickness>0 && console_data->border_color.argb!=GColorClear.argb)
+    top++;
+#endif
+  return GRect(bounds.origin.x, top, bounds.size.w, margin_bounds.origin.y + margin_bounds.size.h - top);
+}
+
+// Draws just the rows written since the last frame.  Returns false if the whole layer needs to be repainted instead.
+static bool console_layer_draw_new_rows(Layer *console_layer, GContext *ctx, GRect bounds, GRect margin_bounds, int16_t header_height) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  GRect screen_bounds = layer_convert_rect_to_screen(console_layer, layer_get_bounds(console_layer));
+  if(console_data->redraw_full                                                 ||
+     !console_data->follow_tail                                               ||  // Scrolled back: new rows aren't on screen
+#ifdef PBL_ROUND
+     console_data->round_layout                                               ||  // Rows change width as they move up
+#endif
+     console_data->layer_background_color.argb==GColorClear.argb              ||  // Nothing to paint behind the new rows
+     header_height != console_data->drawn_header_height                       ||
+     !grect_equal(&screen_bounds, &console_data->drawn_bounds)                ||
+     console_layer_get_style_hash(console_data) != console_data->drawn_style  ||
+     console_data->drawn_oldest_seq < console_layer_get_oldest_seq(console_data))  // Something on screen has been evicted
+    return false;
+
+  // The new chunks have to start a row of their own, so the previous newest chunk has to end in a newline
+  uint32_t new_chunks = console_data->chunk_seq - console_data->drawn_seq;
+  uint16_t first_new  = console_data->chunk_count - new_chunks;
+  if(new_chunks>0) {
+    if(new_chunks >= console_data->chunk_count)
+      return false;
+    if(!console_layer_chunk_ends_row(console_data, first_new - 1))
+      return false;
+  }
+
+  // Lay out the new rows to see how far they push the old ones up
+  GRect rows_rect = console_layer_get_rows_rect(console_data, bounds, margin_bounds, header_height);
+  int16_t delta = new_chunks>0 ? margin_bounds.size.h - console_layer_draw_rows(console_data, NULL, bounds, margin_bounds, console_data->chunk_count, first_new, NULL) : 0;
+  if(delta < 0 || delta >= rows_rect.size.h)
+    return false;
+
+#ifndef CONSOLE_LAYER_NO_REPEATS
+  // A repeat only changes the count on the end of the newest row, so that row is drawn again where it is (as long as
+  // it's still the same height, and nothing's been written after it)
+  int16_t  repeat_height = 0;
+  uint16_t repeat_first  = first_new;
+  if(first_new>0 && console_layer_get_chunk(console_data, first_new - 1)->repeats != console_data->drawn_repeats) {
+    if(new_chunks>0)
+      return false;
+    repeat_first = console_layer_get_row_start(console_data, first_new - 1);
+    repeat_height = margin_bounds.size.h - console_layer_draw_rows(console_data, NULL, bounds, margin_bounds, console_data->chunk_count, repeat_first, NULL);
+    if(repeat_height != console_data->drawn_tail_height || repeat_height >= rows_rect.size.h)
+      return false;
+  }
+#endif
+
+  // Make sure the last frame is still there, then move it up
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if(!frame_buffer)
+    return false;
+  GRect screen_rect = layer_convert_rect_to_screen(console_layer, rows_rect);
+  bool scrolled = console_layer_checksum_pixels(frame_buffer, screen_rect) == console_data->drawn_checksum &&
+                  (delta == 0 || console_layer_scroll_pixels(frame_buffer, screen_rect, delta, console_data->layer_background_color));
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  if(!scrolled)
+    return false;
+
+  // Draw the new rows into the space left at the bottom
+  if(delta>0) {
+    graphics_context_set_fill_color(ctx, console_data->layer_background_color);
+    graphics_fill_rect(ctx, GRect(rows_rect.origin.x, rows_rect.origin.y + rows_rect.size.h - delta, rows_rect.size.w, delta), 0, GCornerNone);
+    console_layer_draw_rows(console_data, ctx, bounds, margin_bounds, console_data->chunk_count, first_new, NULL);
+  }
+#ifndef CONSOLE_LAYER_NO_REPEATS
+  if(repeat_height>0) {
+    graphics_context_set_fill_color(ctx, console_data->layer_background_color);
+    graphics_fill_rect(ctx, GRect(rows_rect.origin.x, rows_rect.origin.y + rows_rect.size.h - repeat_height, rows_rect.size.w, repeat_height), 0, GCornerNone);
+    console_layer_draw_rows(console_data, ctx, bounds, margin_bounds, console_data->chunk_count, repeat_first, NULL);
+  }
+#endif
+  return true;
+}
+
+// Remembers what's on screen for the next incremental redraw
+static void console_layer_remember_frame(Layer *console_layer, GContext *ctx, GRect bounds, GRect margin_bounds, int16_t header_height) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  console_data->redraw_full = !frame_buffer;
+  if(!frame_buffer)
+    return;
+  console_data->drawn_seq           = console_data->chunk_seq;
+  console_data->drawn_style         = console_layer_get_style_hash(console_data);
+  console_data->drawn_bounds        = layer_convert_rect_to_screen(console_layer, layer_get_bounds(console_layer));
+  console_data->drawn_header_height = header_height;
+  console_data->drawn_checksum      = console_layer_checksum_pixels(frame_buffer, layer_convert_rect_to_screen(console_layer, console_layer_get_rows_rect(console_data, bounds, margin_bounds, header_height)));
+  graphics_release_frame_buffer(ctx, frame_buffer);
+#ifndef CONSOLE_LAYER_NO_REPEATS
+  console_data->drawn_repeats       = console_data->chunk_count>0 ? console_layer_get_chunk(console_data, console_data->chunk_count - 1)->repeats : 0;
+  console_data->drawn_tail_height   = console_data->collapse_repeats && console_data->chunk_count>0 ?
+    margin_bounds.size.h - console_layer_draw_rows(console_data, NULL, bounds, margin_bounds, console_data->chunk_count, console_layer_get_row_start(console_data, console_data->chunk_count - 1), NULL) : 0;
+#endif
+}
+
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+// ------------------------------------------------------------------------------------------------------------ //
+// Row Cache
+// ------------------------------------------------------------------------------------------------------------ //
+// Each finished row that's all on screen is copied out of the frame buffer as it's drawn, keyed by the sequence number
+// of its newest chunk, and copied back the next time a row ends with that chunk instead of being laid out and drawn
+// again.  Chunks don't change once they're written (apart from the newest one's repeat count, which is checked), so a
+// row is still good as long as none of its chunks have been evicted and nothing it was drawn with has changed (see
+// console_row_cache_key).  Only 8 bit frame buffers.
+// The rows go in one arena, allocated with the cache, as a ring: each new row goes after the newest one (or back at the
+// start, if it doesn't fit before the end), and the oldest rows are dropped until there's room.  A row dropped from the
+// middle leaves its space until the ring comes back round to it.
+
+// Drops row i
+static void console_layer_forget_cached_row(console_row_cache *row_cache, uint8_t i) {
+  row_cache->count--;
+  memmove(&row_cache->rows[i], &row_cache->rows[i + 1], (row_cache->count - i) * sizeof(row_cache->rows[0]));
+}
+
+// Drops every row with a chunk up to and including sequence number seq on it
+static void console_layer_forget_cached_rows(console_data_struct *console_data, uint32_t seq) {
+  console_row_cache *row_cache = console_data->row_cache;
+  for(uint8_t i=0; row_cache && i<row_cache->count; )
+    if(row_cache->rows[i]->first_seq <= seq)
+      console_layer_forget_cached_row(row_cache, i);
+    else
+      i++;
+}
+
+// Makes room in the arena for a size byte row after the newest one (size can't be more than row_cache_size).  It's only
+// kept once it's added to rows.
+static console_cached_row* console_layer_get_cached_row_room(console_data_struct *console_data, size_t size) {
+  console_row_cache *row_cache = console_data->row_cache;
+  for(; row_cache->count>0; console_layer_forget_cached_row(row_cache, 0)) {
+    if(row_cache->count == CONSOLE_LAYER_ROW_CACHE_ROWS)
+      continue;
+    console_cached_row *newest = row_cache->rows[row_cache->count - 1];
+    size_t head = (uint8_t*)row_cache->rows[0] - row_cache->arena;
+    size_t tail = (uint8_t*)newest - row_cache->arena + CACHED_ROW_SIZE(row_cache->key.width, newest->height);
+    if(tail > head) {  // Free from the newest to the end, and from the start to the oldest
+      if(tail + size <= console_data->row_cache_size)
+        return (console_cached_row*)&row_cache->arena[tail];
+      if(size <= head)
+        return (console_cached_row*)row_cache->arena;
+    } else if(tail + size <= head) {  // Wrapped round: free from the newest to the oldest
+      return (console_cached_row*)&row_cache->arena[tail];
+    }
+  }
+  return (console_cached_row*)row_cache->arena;
+}
+
+// Where a row height tall with its bottom at bottom (relative to margin_bounds, like the rows) is on screen, and whether
+// it's all inside the cache's clip and the frame buffer
+static bool console_layer_get_cached_row_rect(console_data_struct *console_data, GBitmap *frame_buffer, GRect bounds, GRect margin_bounds, int16_t bottom, int16_t height, GRect *rect) {
+  GRect clip = console_data->row_cache->clip, frame = gbitmap_get_bounds(frame_buffer);
+  grect_clip(&clip, &frame);
+  *rect = GRect(console_data->screen_bounds.origin.x + bounds.origin.x, console_data->screen_bounds.origin.y + margin_bounds.origin.y + bottom - height, bounds.size.w, height);
+  GBitmapFormat format = gbitmap_get_format(frame_buffer);
+  return (format==GBitmapFormat8Bit || format==GBitmapFormat8BitCircular) && height > 0 &&
+         rect->origin.x >= clip.origin.x && rect->origin.x + rect->size.w <= clip.origin.x + clip.size.w &&
+         rect->origin.y >= clip.origin.y && rect->origin.y + rect->size.h <= clip.origin.y + clip.size.h;
+}
+
+// Copies the row ending with chunk n back into the frame buffer, if it's in the cache and still good.  Returns its
+// oldest chunk (no older than stop_n) in first_n and its height.
+static bool console_layer_draw_cached_row(console_data_struct *console_data, GContext *ctx, GRect bounds, GRect margin_bounds, uint16_t n, uint16_t stop_n, int16_t bottom, uint16_t *first_n, int16_t *height) {
+  console_row_cache *row_cache = console_data->row_cache;
+  uint32_t seq = console_layer_get_chunk_seq(console_data, n);
+  uint8_t i = 0;
+  while(i<row_cache->count && row_cache->rows[i]->seq != seq) i++;
+  if(i==row_cache->count)
+    return false;
+  console_cached_row *row = row_cache->rows[i];
+  console_chunk *chunk = console_layer_get_chunk(console_data, n);
+  uint16_t row_first_n = console_layer_find_chunk(console_data, row->first_seq);
+  if(row_first_n > n || console_layer_get_chunk_seq(console_data, row_first_n) != row->first_seq || row->length != chunk->length
+#ifndef CONSOLE_LAYER_NO_REPEATS
+     || row->repeats != chunk->repeats
+#endif
+    ) {  // Changed since (or partly evicted)
+    console_layer_forget_cached_row(row_cache, i);
+    return false;
+  }
+#ifdef PBL_ROUND
+  if(console_data->round_layout && row->bottom != bottom)
+    return false;  // It'd be laid out to a different width here
+#endif
+  if(row_first_n < stop_n)
+    return false;
+
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if(!frame_buffer)
+    return false;
+  GRect rect;
+  bool copied = console_layer_get_cached_row_rect(console_data, frame_buffer, bounds, margin_bounds, bottom, row->height, &rect);
+  for(int16_t y=0; copied && y<rect.size.h; y++) {
+    GBitmapDataRowInfo info = gbitmap_get_data_row_info(frame_buffer, rect.origin.y + y);
+    int16_t x0 = rect.origin.x > info.min_x ? rect.origin.x : info.min_x;
+    int16_t x1 = rect.origin.x + rect.size.w - 1 < info.max_x ? rect.origin.x + rect.size.w - 1 : info.max_x;
+    if(x0 <= x1)
+      memcpy(info.data + x0, &row->pixels[y * rect.size.w + x0 - rect.origin.x], x1 - x0 + 1);
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  if(!copied)
+    return false;
+  *first_n = row_first_n;
+  *height  = row->height;
+  return true;
+}
+
+// Keeps a copy of the row just drawn (chunks first_n to n, with its bottom at bottom), making room by dropping older rows.
+// Rows that aren't all on screen (or are older than every row already kept, when it's full) aren't kept.
+static void console_layer_cache_row(console_data_struct *console_data, GContext *ctx, GRect bounds, GRect margin_bounds, uint16_t first_n, uint16_t n, int16_t bottom, int16_t height) {
+  console_row_cache *row_cache = console_data->row_cache;
+  uint32_t seq = console_layer_get_chunk_seq(console_data, n);
+  size_t size = CACHED_ROW_SIZE(bounds.size.w, height);
+  if(height <= 0 || size > console_data->row_cache_size)
+    return;
+
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if(!frame_buffer)
+    return;
+  GRect rect;
+  console_cached_row *row = NULL;
+  if(console_layer_get_cached_row_rect(console_data, frame_buffer, bounds, margin_bounds, bottom, height, &rect)) {
+    for(uint8_t i=0; i<row_cache->count; i++)
+      if(row_cache->rows[i]->seq == seq) {  // Drawn again, so it's changed
+        console_layer_forget_cached_row(row_cache, i);
+        break;
+      }
+    row = console_layer_get_cached_row_room(console_data, size);
+  }
+  for(int16_t y=0; row && y<rect.size.h; y++) {
+    GBitmapDataRowInfo info = gbitmap_get_data_row_info(frame_buffer, rect.origin.y + y);
+    if(info.min_x > rect.origin.x || info.max_x < rect.origin.x + rect.size.w - 1) {  // Cut off by the edge of a round screen
+      row = NULL;
+    } else {
+      memcpy(&row->pixels[y * rect.size.w], info.data + rect.origin.x, rect.size.w);
+    }
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  if(!row)
+    return;
+
+  row->seq       = seq;
+  row->first_seq = console_layer_get_chunk_seq(console_data, first_n);
+  row->length    = console_layer_get_chunk(console_data, n)->length;
+#ifndef CONSOLE_LAYER_NO_REPEATS
+  row->repeats   = console_layer_get_chunk(console_data, n)->repeats;
+#endif
+  row->bottom    = bottom;
+  row->height    = height;
+  row_cache->rows[row_cache->count++] = row;
+}
+
+// Throws every row out if anything they were drawn with has changed, and works out where rows can go this frame
+static void console_layer_check_row_cache(Layer *console_layer, GRect bounds, GRect margin_bounds, int16_t header_height) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_row_cache *row_cache = console_data->row_cache;
+  if(!row_cache)
+    return;
+  console_row_cache_key key;
+  memset(&key, 0, sizeof(key));  // (padding is compared too)
+  key.style      = console_layer_get_style_hash(console_data);
+  key.width      = bounds.size.w;
+  key.text_x     = margin_bounds.origin.x - bounds.origin.x;
+  key.text_width = margin_bounds.size.w;
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  key.view_level = console_data->view_level;
+#endif
+#ifndef CONSOLE_LAYER_NO_FIND
+  if(console_data->highlight.length>0) {
+    key.highlight_seq    = console_data->highlight.seq;
+    key.highlight_index  = console_data->highlight.index;
+    key.highlight_length = console_data->highlight.length;
+  }
+#endif
+#ifdef PBL_ROUND
+  if((key.round = console_data->round_layout))
+    key.round_frame = console_data->round_frame;
+#endif
+  if(memcmp(&key, &row_cache->key, sizeof(key))) {
+    console_layer_forget_cached_rows(console_data, UINT32_MAX);
+    row_cache->key = key;
+  }
+
+  // Rows only go under the header, on the layer's own background
+  row_cache->clip = GRectZero;
+  if(console_data->layer_background_color.argb!=GColorClear.argb)
+    row_cache->clip = layer_convert_rect_to_screen(console_layer, console_layer_get_rows_rect(console_data, bounds, margin_bounds, header_height));
+}
+
+// The cache and its arena are allocated here in one go (and freed here, by 0), so drawing never touches the heap
+void console_layer_set_row_cache_size(Layer *console_layer, size_t row_cache_size) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(row_cache_size == console_data->row_cache_size)
+    return;
+  free(console_data->row_cache);
+  console_data->row_cache      = row_cache_size>0 ? malloc(sizeof(console_row_cache) + row_cache_size) : NULL;
+  console_data->row_cache_size = console_data->row_cache ? row_cache_size : 0;
+  if(console_data->row_cache)
+    memset(console_data->row_cache, 0, sizeof(console_row_cache));
+}
+#endif
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Scrollback
+// ------------------------------------------------------------------------------------------------------------ //
+// Normally the newest row sits at the bottom of the layer.  Scrolling back anchors the bottom row to a chunk instead
+// (by sequence number, so writes and evictions don't move it), and scrolling a row just walks to the next chunk that
+// ends a row from there, rather than laying everything out again from the newest chunk.
+
+// Works out where the rows go: inside the border and margin, under the header.  Returns the header's height.
+static int16_t console_layer_get_rows_bounds(Layer *console_layer, GRect *bounds, GRect *margin_bounds) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  *bounds = layer_get_bounds(console_layer);
+
+#ifndef CONSOLE_LAYER_NO_BORDER
+  // If there's a border, inset the layer's contents
+  if(console_data->border_enabled && console_data->border_thickness>0)
+    *bounds = grect_inset(*bounds, GEdgeInsets(console_data->border_thickness));
+#endif
+
+  // Set internal margin for the layer
+  *margin_bounds = grect_inset(*bounds, GEdgeInsets(MARGIN_TOP_BOTTOM, MARGIN_LEFT_RIGHT));
+  console_layer_check_layout_cache(console_data, console_layer_get_text_width(console_layer));
+#ifdef PBL_ROUND
+  console_layer_check_round_frame(console_layer, *margin_bounds);
+#endif
+
+#ifdef CONSOLE_LAYER_NO_HEADER
+  return 0;
+#else
+  if(!console_data->header_enabled)
+    return 0;
+#ifndef CONSOLE_LAYER_NO_MONO_FONT
+  if(console_data->header_font == CONSOLE_LAYER_FONT_MONO)
+    return console_layer_measure_mono_text(console_data->header_text, true, bounds->size.w).h;
+#endif
+  COUNT_STAT(console_data, measure_calls, 1);
+  return graphics_text_layout_get_content_size(console_data->header_text, console_data->header_font, *bounds, GTextOverflowModeTrailingEllipsis, console_data->header_text_alignment).h;
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+// rows > 0 scrolls back towards older rows, rows < 0 forward towards the newest.  Scrolling forward to the newest row
+// follows the tail again.  Scrolling back stops once the oldest chunk is all on screen.
+void console_layer_scroll_by(Layer *console_layer, int rows) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(console_data->chunk_count==0 || rows==0) return;
+  uint16_t n = console_layer_get_view_end(console_data) - 1;  // Newest chunk on the bottom row
+  for(uint16_t first; !console_layer_row_shown(console_data, n) && (first = console_layer_get_row_start(console_data, n)) > 0; )
+    n = first - 1;  // The bottom row as drawn (rows under it with nothing drawn don't count)
+
+  GRect bounds, margin_bounds;
+  int16_t header_height = rows>0 ? console_layer_get_rows_bounds(console_layer, &bounds, &margin_bounds) : 0;
+  for(; rows>0; rows--) {
+    // Stop if everything before the bottom row is already on screen
+    uint16_t oldest_n;
+    if(console_layer_draw_rows(console_data, NULL, bounds, margin_bounds, n + 1, 0, &oldest_n) >= header_height && oldest_n==0)
+      break;
+    // The row before this one ends with the newest chunk before it that ends a row (passing over rows with nothing drawn)
+    uint16_t row = n;
+    do {
+      uint16_t first = console_layer_get_row_start(console_data, row);
+      if(first==0) break;
+      row = first - 1;
+    } while(!console_layer_row_shown(console_data, row));
+    if(row==n || !console_layer_row_shown(console_data, row)) break;
+    n = row;
+  }
+  for(; rows<0 && n < console_data->chunk_count - 1; rows++) {
+    do {
+      n++;
+      while(n < console_data->chunk_count - 1 && !console_layer_chunk_ends_row(console_data, n)) n++;
+    } while(n < console_data->chunk_count - 1 && !console_layer_row_shown(console_data, n));
+  }
+
+  console_data->follow_tail = n == console_data->chunk_count - 1;
+  console_data->scroll_seq  = console_layer_get_chunk_seq(console_data, n);
+  console_data->redraw_full = true;
+  console_layer_mark_dirty(console_layer);
+}
+
+void console_layer_scroll_to_bottom(Layer *console_layer) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(console_data->follow_tail) return;
+  console_data->follow_tail = true;
+  console_data->redraw_full = true;
+  console_layer_mark_dirty(console_layer);
+}
+
+// Following the tail keeps the newest row at the bottom.  Not following keeps the rows on screen where they are as more
+// text is written (until they're evicted).
+void console_layer_set_follow_tail(Layer *console_layer, bool follow_tail) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(follow_tail) {
+    console_layer_scroll_to_bottom(console_layer);
+  } else if(console_data->follow_tail) {
+    console_data->follow_tail = false;
+    console_data->scroll_seq  = console_data->chunk_seq - 1;
+  }
+}
+
+#ifndef CONSOLE_LAYER_NO_FIND
+// ------------------------------------------------------------------------------------------------------------ //
+// Find
+// ------------------------------------------------------------------------------------------------------------ //
+// Each chunk's text is searched where it sits in the buffer, from just after its header (so the style byte and image
+// pointer are never matched), with a Boyer-Moore-Horspool skip table: the needle is lined up against the text and
+// checked from its last byte back, and on a mismatch it moves on by how far the text's byte under its last byte is from
+// the end of the needle.  Positions are worked out relative to the chunk's text, and only turned into buffer indexes
+// (wrapping around to the start) as bytes are read, so a chunk that straddles the end of the buffer is searched like any
+// other.  Compact text is unpacked into the scratch buffer first, a chunk at a time.
+typedef struct console_search {
+  const char *needle;
+  size_t      length;
+  uint8_t     skip[256];  // How far to move the needle on, by the text's byte under its last byte
+} console_search;
+
+static bool console_search_init(console_search *search, const char *needle) {
+  search->needle = needle;
+  search->length = needle ? strlen(needle) : 0;
+  if(search->length==0 || search->length > 255)
+    return false;
+  memset(search->skip, search->length, sizeof(search->skip));
+  for(size_t i=0; i<search->length - 1; i++)
+    search->skip[(uint8_t)needle[i]] = search->length - 1 - i;
+  return true;
+}
+
+// Searches length bytes of text starting at index in a ring of size bytes.  Returns where (from the start of the text)
+// the first match at or after from starts, or with before set, the last match that starts before from (-1 = none).
+static int32_t console_search_text(const console_search *search, const char *ring, size_t size, size_t index, size_t length, size_t from, bool before) {
+  int32_t found = -1;
+  size_t  last  = search->length - 1;
+  for(size_t at = before ? 0 : from; at + search->length <= length && !(before && at >= from); ) {
+    size_t end = index + at + last;
+    if(end >= size) end -= size;
+    uint8_t c = ring[end];
+    if(c == (uint8_t)search->needle[last]) {
+      size_t i = last;
+      for(size_t p = end; i>0; i--) {
+        p = (p ? p : size) - 1;
+        if(ring[p] != search->needle[i - 1]) break;
+      }
+      if(i==0) {
+        found = at;
+        if(!before) break;
+      }
+    }
+    at += search->skip[c];
+  }
+  return found;
+}
+
+// Searches chunk n's text (see console_search_text), unless it's hidden
+static int32_t console_layer_search_chunk(console_data_struct *console_data, const console_search *search, uint16_t n, size_t from, bool before) {
+  console_chunk *chunk = console_layer_get_chunk(console_data, n);
+  uint8_t settings = console_layer_get_style_byte(console_data, chunk);
+#ifndef CONSOLE_LAYER_NO_LEVELS
+  if(GET_LEVEL(settings) < console_data->view_level)
+    return -1;
+#endif
+  size_t header_length = console_layer_get_header_length(settings);
+  size_t text_index    = (chunk->offset + header_length) % console_data->buffer_size;
+  size_t text_length   = chunk->length - header_length - 1;  // Not counting the terminating 0
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+  if(IS_COMPACT(settings)) {
+    COUNT_STAT(console_data, scratch_allocs, 1);
+    text_length = console_layer_expand_text(console_data, text_index, text_length, console_data->scratch, console_data->buffer_size);
+    return console_search_text(search, console_data->scratch, console_data->buffer_size, 0, text_length, from, before);
+  }
+#endif
+  return console_search_text(search, console_data->buffer, console_data->buffer_size, text_index, text_length, from, before);
+}
+
+// Highlights the match in chunk n, and if it isn't on screen, scrolls so its row is the bottom one (or lower, near the
+// oldest rows, so they still fill the layer like scrolling back leaves them).  Rows are laid out from the cached heights,
+// like console_layer_scroll_by does, so nothing's measured again.
+static void console_layer_show_match(Layer *console_layer, uint16_t n, const ConsoleMatch *match) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_data->highlight = *match;
+
+  GRect bounds, margin_bounds;
+  int16_t header_height = console_layer_get_rows_bounds(console_layer, &bounds, &margin_bounds);
+  uint16_t view_end = console_layer_get_view_end(console_data), top_n;
+  bool top_row_whole = console_layer_draw_rows(console_data, NULL, bounds, margin_bounds, view_end, 0, &top_n) >= header_height;
+  if(!top_row_whole)  // The top row's cut off: only the rows under it count
+    while(top_n < view_end - 1 && !console_layer_chunk_ends_row(console_data, top_n++)) {}
+  if(n < top_n || n >= view_end) {
+    uint16_t row_end = n;
+    while(row_end < console_data->chunk_count - 1 && !console_layer_chunk_ends_row(console_data, row_end)) row_end++;
+    for(uint16_t next; row_end < console_data->chunk_count - 1; row_end = next) {
+      next = row_end + 1;
+      while(next < console_data->chunk_count - 1 && !console_layer_chunk_ends_row(console_data, next)) next++;
+      if(console_layer_draw_rows(console_data, NULL, bounds, margin_bounds, next + 1, 0, NULL) < header_height)
+        break;  // Another row would push the top one off
+    }
+    console_data->follow_tail = row_end == console_data->chunk_count - 1;
+    console_data->scroll_seq  = console_layer_get_chunk_seq(console_data, row_end);
+  }
+  console_data->redraw_full = true;
+  console_layer_mark_dirty(console_layer);
+}
+
+// Looks for the next match older (back) or newer than match, starting in match's own chunk
+static bool console_layer_find_from(Layer *console_layer, const char *needle, ConsoleMatch *match, bool back) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  console_search search;
+  if(!console_search_init(&search, needle) || console_data->chunk_count==0)
+    return false;
+
+  int32_t n = console_layer_find_chunk(console_data, match->seq);
+  size_t  from;
+  if(n < console_data->chunk_count && console_layer_get_chunk_seq(console_data, n) == match->seq) {
+    from = back ? match->index : match->index + 1u;
+  } else if(back) {  // Evicted (or past the newest): carry on from the next older chunk
+    n--; from = SIZE_MAX;
+  } else {           // Evicted: carry on from the next newer one
+    from = 0;
+  }
+
+  for(; n>=0 && n<console_data->chunk_count; n += back ? -1 : 1, from = back ? SIZE_MAX : 0) {
+    int32_t at = console_layer_search_chunk(console_data, &search, n, from, back);
+    if(at >= 0) {
+      *match = (ConsoleMatch){.seq = console_layer_get_chunk_seq(console_data, n), .index = at, .length = search.length};
+      console_layer_show_match(console_layer, n, match);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool console_layer_find(Layer *console_layer, const char *needle, ConsoleMatch *match) {
+  ConsoleMatch newest = {.seq = ((console_data_struct*)layer_get_data(console_layer))->chunk_seq};  // Just past the newest chunk
+  if(!console_layer_find_from(console_layer, needle, &newest, true))
+    return false;
+  *match = newest;
+  return true;
+}
+
+bool console_layer_find_previous(Layer *console_layer, const char *needle, ConsoleMatch *match) {return console_layer_find_from(console_layer, needle, match, true);}
+bool console_layer_find_next    (Layer *console_layer, const char *needle, ConsoleMatch *match) {return console_layer_find_from(console_layer, needle, match, false);}
+
+void console_layer_clear_highlight(Layer *console_layer) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(console_data->highlight.length==0) return;
+  console_data->highlight.length = 0;
+  console_data->redraw_full = true;
+  console_layer_mark_dirty(console_layer);
+}
+#endif
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+static void console_layer_update(Layer *console_layer, GContext *ctx) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+#ifdef CONSOLE_LAYER_STATS
+  time_t   start_s;
+  uint16_t start_ms = time_ms(&start_s, NULL);
+  uint32_t start_rows = console_data->stats.rows_drawn;
+#endif
+  graphics_context_set_stroke_width(ctx, 1);
+#if !defined(CONSOLE_LAYER_NO_MONO_FONT) || !defined(CONSOLE_LAYER_NO_ROW_CACHE)
+  console_data->screen_bounds = layer_convert_rect_to_screen(console_layer, layer_get_bounds(console_layer));
+#endif
+  GRect bounds, margin_bounds;
+  int16_t header_height = console_layer_get_rows_bounds(console_layer, &bounds, &margin_bounds);
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+  console_layer_check_row_cache(console_layer, bounds, margin_bounds, header_height);
+#endif
+
+  // Just draw the new rows if that's all that's changed, otherwise repaint everything
+  if(!console_data->incremental_redraw || !console_layer_draw_new_rows(console_layer, ctx, bounds, margin_bounds, header_height)) {
+    // Layer Background
+    if(console_data->layer_background_color.argb!=GColorClear.argb) {
+      graphics_context_set_fill_color(ctx, console_data->layer_background_color);
+      graphics_fill_rect(ctx, (GRect){.origin = GPoint(0, 0), .size = layer_get_bounds(console_layer).size}, 0, GCornerNone);
+    }
+
+    // Display Rows
+    uint16_t oldest_n;
+    console_layer_draw_rows(console_data, ctx, bounds, margin_bounds, console_layer_get_view_end(console_data), 0, &oldest_n);
+    console_data->drawn_oldest_seq = oldest_n < console_data->chunk_count ? console_layer_get_chunk_seq(console_data, oldest_n) : console_data->chunk_seq;
+  }
+
+#ifndef CONSOLE_LAYER_NO_HEADER
+  // Draw Header (no internal margin)
+  if(header_height>0) {
+    if(console_data->header_background_color.argb!=GColorClear.argb)
+      graphics_context_set_fill_color(ctx, console_data->header_background_color);
+    else if(console_data->layer_background_color.argb!=GColorClear.argb)
+      graphics_context_set_fill_color(ctx, console_data->layer_background_color);
+    else
+      graphics_context_set_fill_color(ctx, GColorWhite);  // The Console Layer Library currently doesn't support clear headers due to text/images writing into the header area
+    graphics_fill_rect(ctx, GRect(bounds.origin.x, bounds.origin.y, bounds.size.w, header_height), 0, GCornerNone);
+    
+    if(console_data->header_text_color.argb!=GColorClear.argb) {
+      graphics_context_set_text_color(ctx, console_data->header_text_color);
+      console_layer_draw_text(console_data, ctx, console_data->header_text, console_data->header_font, true, GRect(bounds.origin.x, bounds.origin.y, bounds.size.w, header_height), console_data->header_text_alignment, console_data->header_text_color);
+    }
+  } // END Draw Header
+#endif
+
+#ifndef CONSOLE_LAYER_NO_BORDER
+  // Draw Border
+  if(console_data->border_enabled && console_data->border_thickness>0 && console_data->border_color.argb!=GColorClear.argb) {
+    graphics_context_set_fill_color  (ctx, console_data->border_color);
+    graphics_context_set_stroke_color(ctx, console_data->border_color);
+    if(header_height>0)
+      graphics_draw_line(ctx, GPoint(bounds.origin.x, bounds.origin.y + header_height), GPoint(bounds.origin.x + bounds.size.w, bounds.origin.y + header_height));
+    GRect layer_bounds = layer_get_bounds(console_layer);
+    graphics_fill_rect(ctx, GRect(0, 0, layer_bounds.size.w, console_data->border_thickness), 0, GCornerNone);
+    graphics_fill_rect(ctx, GRect(0, 0, console_data->border_thickness, layer_bounds.size.h), 0, GCornerNone);
+    graphics_fill_rect(ctx, GRect(layer_bounds.size.w-console_data->border_thickness, 0, console_data->border_thickness, layer_bounds.size.h), 0, GCornerNone);
+    graphics_fill_rect(ctx, GRect(0, layer_bounds.size.h-console_data->border_thickness, layer_bounds.size.w, console_data->border_thickness), 0, GCornerNone);
+  } // END Draw Border
+#endif
+
+  if(console_data->incremental_redraw)
+    console_layer_remember_frame(console_layer, ctx, bounds, margin_bounds, header_height);
+
+#ifdef CONSOLE_LAYER_STATS
+  time_t   end_s;
+  uint16_t end_ms     = time_ms(&end_s, NULL);
+  uint32_t elapsed_ms = (end_s - start_s) * 1000 + end_ms - start_ms;
+  uint32_t rows       = console_data->stats.rows_drawn - start_rows;
+  console_data->stats.redraws++;
+  console_data->stats.update_ms += elapsed_ms;
+  if(elapsed_ms > console_data->stats.max_update_ms) console_data->stats.max_update_ms = elapsed_ms;
+  if(rows > console_data->stats.max_rows_drawn)      console_data->stats.max_rows_drawn = rows;
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+
+
+
+
+
+
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Logging
+// ------------------------------------------------------------------------------------------------------------ //
+#define CONSOLE_LOG_MAX_LENGTH 128
+
+static Layer   *log_layer;
+static uint8_t  log_level = CONSOLE_LOG_LEVEL_VERBOSE;
+
+void console_log_set_layer(Layer *console_layer) {log_layer = console_layer;}
+void console_log_set_level(uint8_t level)        {log_level = level;}
+
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+typedef struct console_log_style {
+  GColor text_color;
+  GColor background_color;
+} console_log_style;
+
+static console_log_style log_styles[] = {  // ERROR, WARNING, INFO, DEBUG, VERBOSE
+  {.text_color = {.argb=PBL_IF_COLOR_ELSE(GColorRedARGB8,    GColorWhiteARGB8)}, .background_color = {.argb=PBL_IF_COLOR_ELSE(GColorClearARGB8, GColorBlackARGB8)}},
+  {.text_color = {.argb=PBL_IF_COLOR_ELSE(GColorOrangeARGB8, GColorClearARGB8)}, .background_color = {.argb=GColorClearARGB8}},
+  {.text_color = {.argb=GColorClearARGB8},                                       .background_color = {.argb=GColorClearARGB8}},
+  {.text_color = {.argb=GColorClearARGB8},                                       .background_color = {.argb=GColorClearARGB8}},
+  {.text_color = {.argb=GColorClearARGB8},                                       .background_color = {.argb=GColorClearARGB8}},
+};
+
+static console_log_style* console_log_get_style(uint8_t level) {
+  return &log_styles[level<=CONSOLE_LOG_LEVEL_ERROR ? 0 : level<=CONSOLE_LOG_LEVEL_WARNING ? 1 : level<=CONSOLE_LOG_LEVEL_INFO ? 2 : level<=CONSOLE_LOG_LEVEL_DEBUG ? 3 : 4];
+}
+
+void console_log_set_style(uint8_t level, GColor text_color, GColor background_color) {
+  console_log_style *style = console_log_get_style(level);
+  style->text_color       = text_color;
+  style->background_color = background_color;
+}
+#endif
+
+// The layer's copy is formatted straight into its buffer at full length: only APP_LOG's is cut short
+void console_vlog(uint8_t level, const char *src_filename, int src_line_number, const char *format, va_list args) {
+  if(level > log_level)
+    return;
+  va_list layer_args;
+  va_copy(layer_args, args);
+  char message[CONSOLE_LOG_MAX_LENGTH + 1];
+  vsnprintf(message, sizeof(message), format, args);
+  app_log(level, src_filename, src_line_number, "%s", message);
+
+  if(log_layer) {
+#ifndef CONSOLE_LAYER_NO_LEVELS
+    // Written at the message's level, whatever level the layer's writing at
+    console_data_struct *console_data = (console_data_struct*)layer_get_data(log_layer);
+    uint8_t layer_level = console_data->level;
+    console_data->level = level<=CONSOLE_LOG_LEVEL_ERROR ? ConsoleLayerLevelError : level<=CONSOLE_LOG_LEVEL_WARNING ? ConsoleLayerLevelWarning :
+                          level<=CONSOLE_LOG_LEVEL_INFO  ? ConsoleLayerLevelInfo  : ConsoleLayerLevelDebug;
+#endif
+#ifdef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+    console_layer_vprintfln(log_layer, format, layer_args);
+#else
+    console_log_style *style = console_log_get_style(level);
+    console_layer_vprintf_styled(log_layer, style->text_color, style->background_color, GFontInherit, GTextAlignmentInherit, WordWrapInherit, true, format, layer_args);
+#endif
+#ifndef CONSOLE_LAYER_NO_LEVELS
+    console_data->level = layer_level;
+#endif
+  }
+  va_end(layer_args);
+}
+
+void console_log(uint8_t level, const char *src_filename, int src_line_number, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  console_vlog(level, src_filename, src_line_number, format, args);
+  va_end(args);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Export
+// ------------------------------------------------------------------------------------------------------------ //
+// There's only one outbox, so only one export at a time.  Only one message is ever in flight: the next batch is packed
+// (into the layer's scratch buffer) when the last one's been delivered, so a slow phone just slows the export down.
+#ifndef CONSOLE_LAYER_EXPORT_RETRIES
+#define CONSOLE_LAYER_EXPORT_RETRIES  3
+#endif
+#ifndef CONSOLE_LAYER_EXPORT_RETRY_MS
+#define CONSOLE_LAYER_EXPORT_RETRY_MS 500    // Wait before trying a failed message again
+#endif
+
+static struct {
+  Layer                      *layer;          // Layer being exported (NULL = none)
+  ConsoleLayerExportCallback  callback;
+  uint32_t                    seq;            // Next byte to send: offset bytes into the text of chunk seq
+  size_t                      offset;
+  uint32_t                    sent_seq;       // Where the message in flight ends
+  size_t                      sent_offset;
+  uint8_t                     retries;
+  AppTimer                   *retry_timer;
+  AppMessageOutboxSent        app_sent;       // The app's handlers, put back when the export's done
+  AppMessageOutboxFailed      app_failed;
+} console_export;
+
+static void console_layer_export_finish(bool finished) {
+  if(console_export.retry_timer)
+    app_timer_cancel(console_export.retry_timer);
+  console_export.retry_timer = NULL;
+  app_message_register_outbox_sent(console_export.app_sent);
+  app_message_register_outbox_failed(console_export.app_failed);
+  Layer *console_layer = console_export.layer;
+  console_export.layer = NULL;
+  if(console_export.callback)
+    console_export.callback(console_layer, console_export.seq, finished);
+}
+
+// Copies up to room bytes of text into out, from offset bytes into chunk seq on, and moves seq and offset past them.
+// Headers are left out, the fragments of a chunk are joined into one string and packed text is unpacked.
+static size_t console_layer_export_pack(console_data_struct *console_data, uint32_t *seq, size_t *offset, char *out, size_t room) {
+  uint16_t n = console_layer_find_chunk(console_data, *seq);
+  size_t length = 0;
+  while(n < console_data->chunk_count && length < room) {
+    console_chunk *chunk = console_layer_get_chunk(console_data, n);
+    uint8_t style_byte   = console_layer_get_style_byte(console_data, chunk);
+    size_t header_length = console_layer_get_header_length(style_byte);
+    size_t text_length   = chunk->length - header_length;  // Counting the terminating 0
+    size_t index         = chunk->offset + header_length;
+    while(*offset < text_length && length < room) {
+      char c = console_data->buffer[(index + *offset) % console_data->buffer_size];
+#ifndef CONSOLE_LAYER_NO_REPEATS
+      char count[10];
+      size_t count_length = *offset == text_length - 2 ? console_layer_get_repeat_text(chunk, count) : 0;
+      if(count_length) {  // A repeated line's count goes with its newline, as it's drawn (the count when it's packed)
+        if(length + count_length + 1 > room)
+          return length;
+        memcpy(&out[length], count, count_length);
+        length += count_length;
+      }
+#endif
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+      if(IS_COMPACT(style_byte) && (c&0x80)) {
+        size_t token_length = console_layer_token_length(c&0x7F);
+        if(length + token_length > room)
+          return length;  // Goes in the next batch
+        memcpy(&out[length], compact_tokens[c&0x7F], token_length);
+        length += token_length;
+        (*offset)++;
+        continue;
+      }
+#endif
+      (*offset)++;
+      if(c || *offset == text_length)
+        out[length++] = c;
+    }
+    if(*offset == text_length) {
+      *seq    = ++n < console_data->chunk_count ? console_layer_get_chunk_seq(console_data, n) : console_data->chunk_seq;
+      *offset = 0;
+    }
+  }
+  return length;
+}
+
+static void console_layer_export_send(void);
+
+static void console_layer_export_retry_timer_callback(void *data) {
+  console_export.retry_timer = NULL;
+  console_layer_export_send();
+}
+
+static void console_layer_export_retry(void) {
+  if(++console_export.retries > CONSOLE_LAYER_EXPORT_RETRIES)
+    console_layer_export_finish(false);
+  else
+    console_export.retry_timer = app_timer_register(CONSOLE_LAYER_EXPORT_RETRY_MS, console_layer_export_retry_timer_callback, NULL);
+}
+
+// Packs as much as fits in the outbox and sends it
+static void console_layer_export_send(void) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_export.layer);
+
+  // Skip anything evicted since the last batch
+  uint16_t n = console_layer_find_chunk(console_data, console_export.seq);
+  if(n < console_data->chunk_count && console_layer_get_chunk_seq(console_data, n) != console_export.seq) {
+    console_export.seq    = console_layer_get_chunk_seq(console_data, n);
+    console_export.offset = 0;
+  }
+  if(n == console_data->chunk_count) {  // All caught up
+    console_layer_export_finish(true);
+    return;
+  }
+
+  DictionaryIterator *iter;
+  if(app_message_outbox_begin(&iter) != APP_MSG_OK) {  // Busy with someone else's message
+    console_layer_export_retry();
+    return;
+  }
+  size_t room     = (uint8_t*)iter->end - (uint8_t*)iter->cursor;
+  size_t overhead = dict_calc_buffer_size(2, (uint32_t)sizeof(uint32_t), (uint32_t)0);
+  room = room > overhead ? room - overhead : 0;
+  if(room > console_data->buffer_size) room = console_data->buffer_size;  // Size of the scratch buffer
+
+  console_export.sent_seq    = console_export.seq;
+  console_export.sent_offset = console_export.offset;
+  size_t length = console_layer_export_pack(console_data, &console_export.sent_seq, &console_export.sent_offset, console_data->scratch, room);
+  if(length==0 ||  // Outbox is too small to be any use
+     dict_write_uint32(iter, CONSOLE_LAYER_EXPORT_KEY,     console_export.seq) != DICT_OK ||
+     dict_write_data  (iter, CONSOLE_LAYER_EXPORT_KEY + 1, (uint8_t*)console_data->scratch, length) != DICT_OK)
+    console_layer_export_finish(false);
+  else if(app_message_outbox_send() != APP_MSG_OK)
+    console_layer_export_retry();
+}
+
+static void console_layer_export_sent_callback(DictionaryIterator *iter, void *context) {
+  console_export.seq     = console_export.sent_seq;
+  console_export.offset  = console_export.sent_offset;
+  console_export.retries = 0;
+  console_layer_export_send();
+}
+
+static void console_layer_export_failed_callback(DictionaryIterator *iter, AppMessageResult reason, void *context) {
+  console_layer_export_retry();
+}
+
+bool console_layer_export(Layer *console_layer, uint32_t from_seq, ConsoleLayerExportCallback callback) {
+  if(console_export.layer)
+    return false;
+  console_export.layer      = console_layer;
+  console_export.callback   = callback;
+  console_export.seq        = from_seq;
+  console_export.offset     = 0;
+  console_export.retries    = 0;
+  console_export.app_sent   = app_message_register_outbox_sent(console_layer_export_sent_callback);
+  console_export.app_failed = app_message_register_outbox_failed(console_layer_export_failed_callback);
+  console_layer_export_send();
+  return true;
+}
+
+void console_layer_export_cancel(Layer *console_layer) {
+  if(console_export.layer!=console_layer || !console_layer)
+    return;
+  console_export.callback = NULL;
+  console_layer_export_finish(false);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Create and Destroy Layer
+// ------------------------------------------------------------------------------------------------------------ //
+
+// Creates a layer with extra_size bytes after its data, for its index, buffer and scratch if they go there
+static Layer* console_layer_create_with_data_size(GRect frame, size_t extra_size) {
+  Layer *console_layer;
+  if((console_layer = layer_create_with_data(frame, sizeof (console_data_struct) + extra_size))) {
+    console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+    memset(console_data, 0, sizeof(console_data_struct));  // Struct padding is hashed for incremental redraw, so start it all at 0
+
+    layer_set_clips(console_layer, true);
+    console_layer_set_layer_style(console_layer, GColorBlack, GColorClear, fonts_get_system_font(FONT_KEY_GOTHIC_14), GTextAlignmentLeft, WordWrapFalse, true);
+#ifndef CONSOLE_LAYER_NO_BORDER
+    console_layer_set_border_style(console_layer, false, GColorBlack, 1);
+#endif
+#ifndef CONSOLE_LAYER_NO_HEADER
+    console_layer_set_header_style(console_layer, false, GColorBlack, GColorLightGray, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD), GTextAlignmentCenter);
+    console_layer_set_header_text(console_layer, " ");  // If header is "" then no header is displayed (if enabled)
+#endif
+    console_layer_clear(console_layer);
+    layer_set_update_proc(console_layer, console_layer_update);
+  }
+  return console_layer;
+}
+
+Layer* console_layer_create_with_buffer_size(GRect frame, int buffer_size) {
+  Layer *console_layer = console_layer_create_with_data_size(frame, console_layer_storage_size(buffer_size) + buffer_size);  // index, buffer, scratch
+  if(console_layer) {
+    console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+    console_layer_set_storage(console_data, (uint8_t*)(console_data + 1), buffer_size);  // Index just after the struct, the buffer after that
+    console_data->scratch     = console_data->buffer + buffer_size;                     // and the scratch buffer after that
+    console_data->inline_size = buffer_size;
+  }
+  return console_layer;
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+Layer* console_layer_create_in_pool(GRect frame, ConsoleLayerPool *pool, int min_buffer_size, int max_buffer_size) {
+  size_t min_size = POOL_ALIGN(min_buffer_size > 4 ? min_buffer_size : 4);
+  size_t max_size = POOL_ALIGN(max_buffer_size > min_buffer_size ? (max_buffer_size < 0xFFFF ? max_buffer_size : 0xFFFF) : min_buffer_size);
+  Layer *console_layer = console_layer_create_with_data_size(frame, 0);
+  if(console_layer && !console_layer_pool_add(pool, console_layer, min_size, max_size)) {
+    layer_destroy(console_layer);
+    console_layer = NULL;
+  }
+  return console_layer;
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+Layer* console_layer_create(GRect frame) {
+  return console_layer_create_with_buffer_size(frame, DEFAULT_BUFFER_SIZE);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+
+void console_layer_destroy(Layer *console_layer) {
+  console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
+  if(console_data->redraw_timer)  // Don't let a put-off redraw fire on a layer that's gone
+    app_timer_cancel(console_data->redraw_timer);
+  console_layer_persist_write(console_data);  // Save what's left (and cancel the flush timer)
+  free(console_data->persist_dirty);
+  free(console_data->heap_storage);
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+  console_layer_set_row_cache_size(console_layer, 0);
+#endif
+  if(log_layer==console_layer)
+    log_layer = NULL;
+  console_layer_export_cancel(console_layer);
+  console_layer_pool_remove(console_layer);
+  layer_destroy(console_layer);
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Stats
+// ------------------------------------------------------------------------------------------------------------ //
+bool console_layer_get_stats(Layer *console_layer, ConsoleLayerStats *stats) {
+#ifdef CONSOLE_LAYER_STATS
+  *stats = ((console_data_struct*)layer_get_data(console_layer))->stats;
+  return true;
+#else
+  memset(stats, 0, sizeof(ConsoleLayerStats));
+  return false;
+#endif
+}
+
+void console_layer_reset_stats(Layer *console_layer) {
+#ifdef CONSOLE_LAYER_STATS
+  memset(&((console_data_struct*)layer_get_data(console_layer))->stats, 0, sizeof(ConsoleLayerStats));
+#endif
+}
+
+// ------------------------------------------------------------------------------------------------------------ //
 
 
 
@@ -613,7 +3909,20 @@ Layer* console_layer_create(GRect frame) {
 // ------------------------------------------------------------------------------------------------------------ //
 void log_buffer(Layer *console_layer) {
   console_data_struct *console_data = (console_data_struct*)layer_get_data(console_layer);
-  printf("Head/Tail Separator Position: %d", (int)console_data->pos);
+  ConsoleLayerStats stats;
+  if(console_layer_get_stats(console_layer, &stats)) {
+    printf("Written: %d bytes in %d chunks, %d chunks evicted", (int)stats.bytes_written, (int)stats.chunks_written, (int)stats.chunks_evicted);
+    printf("Redraws: %d, %d rows drawn (%d per redraw, max %d)", (int)stats.redraws, (int)stats.rows_drawn, stats.redraws ? (int)(stats.rows_drawn / stats.redraws) : 0, (int)stats.max_rows_drawn);
+    printf("Update time: %d ms total (%d per redraw, max %d)", (int)stats.update_ms, stats.redraws ? (int)(stats.update_ms / stats.redraws) : 0, (int)stats.max_update_ms);
+    printf("Text measured %d times, scratch buffer used %d times", (int)stats.measure_calls, (int)stats.scratch_allocs);
+  }
+  printf("Head Position: %d, %d bytes used in %d chunks", (int)console_data->pos, (int)console_data->buffer_used, (int)console_data->chunk_count);
+  for(uint16_t n=0; n<console_data->chunk_count; n++)              // Log the index, oldest chunk first
+    printf("chunk[%d] offset = %d, length = %d", (int)n, (int)console_layer_get_chunk(console_data, n)->offset, (int)console_layer_get_chunk(console_data, n)->length);
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+  for(uint8_t i=0; i<console_data->style_count; i++)             // Log the style table
+    printf("style[%d] text = %x, background = %x, settings = %x%s", (int)i, console_data->styles[i].text_color.argb, console_data->styles[i].background_color.argb, console_data->styles[i].settings, console_data->styles[i].pinned ? " (pinned)" : "");
+#endif
   //for(int i=console_data->pos; i<console_data->buffer_size; i++)  // Log from current position (the head) to the end of the buffer
   for(uint i=0; i<console_data->buffer_size; i++)                    // Log the whole buffer
     if(console_data->buffer[i]<=127 && console_data->buffer[i]>=32)
@@ -1,5 +1,36 @@
 #pragma once
 #include <pebble.h>
+#include <stdarg.h>
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Configuration
+// ------------------------------------------------------------------------------------------------------------ //
+// Uncomment (or define when compiling everything that includes this) to leave out features an app doesn't use.
+// Each one takes its code out of console.c and its functions out of this header, and the first two make every chunk
+// in the buffer smaller.  Measured sizes are at the top of console.c.
+// ------------------------------------------------------------------------------------------------------------ //
+//#define CONSOLE_LAYER_NO_IMAGES            // No images: chunks don't need room for an image pointer
+//#define CONSOLE_LAYER_NO_PER_CHUNK_STYLE   // All text in the layer's style: no style table, no style byte without images
+//#define CONSOLE_LAYER_NO_HEADER            // No header
+//#define CONSOLE_LAYER_NO_BORDER            // No border
+//#define CONSOLE_LAYER_NO_COMPACT_TEXT      // No compact text encoding (see console_layer_set_compact_text)
+//#define CONSOLE_LAYER_NO_REPEATS           // No repeat counts: chunk index entries are 2 bytes smaller with NO_LEVELS too (see console_layer_set_collapse_repeats)
+//#define CONSOLE_LAYER_NO_LEVELS            // No levels: chunk index entries are 4 bytes smaller (see console_layer_set_level)
+//#define CONSOLE_LAYER_NO_FIND              // No text search (see console_layer_find)
+//#define CONSOLE_LAYER_NO_MONO_FONT         // No built-in mono font (see CONSOLE_LAYER_FONT_MONO)
+//#define CONSOLE_LAYER_NO_ROW_CACHE         // No row cache (see console_layer_set_row_cache_size), always left out on aplite
+
+#if defined(CONSOLE_LAYER_NO_IMAGES) && defined(CONSOLE_LAYER_NO_PER_CHUNK_STYLE)
+  #ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+  #define CONSOLE_LAYER_NO_COMPACT_TEXT     // Chunks have no style byte to mark compact text with
+  #endif
+  #ifndef CONSOLE_LAYER_NO_LEVELS
+  #define CONSOLE_LAYER_NO_LEVELS           // or levels
+  #endif
+#endif
+#if !defined(PBL_COLOR) && !defined(CONSOLE_LAYER_NO_ROW_CACHE)
+  #define CONSOLE_LAYER_NO_ROW_CACHE        // 1 bit frame buffer and not enough RAM to spare for it
+#endif
 
 #define WordWrapFalse   false
 #define WordWrapTrue    true
@@ -9,30 +40,72 @@ enum {GTextAlignmentInherit = 3};
 #define GColorInherit ((GColor8){.argb=GColorClearARGB8})
 #define GFontInherit NULL
 
+#ifndef CONSOLE_LAYER_NO_MONO_FONT
+// Built-in fixed width font (5x7 glyphs in 6x9 pixel cells) for plain log output.  Use it anywhere a GFont goes (the
+// layer's font, a write style, the header's).  It's drawn straight into the frame buffer and laid out without measuring,
+// which costs much less than graphics_draw_text.  Printable ASCII only: anything else is drawn as '?' (× as x).
+extern const uint8_t console_layer_mono_font[];
+#define CONSOLE_LAYER_FONT_MONO ((GFont)console_layer_mono_font)
+#endif
+
 // ------------------------------------------------------------------------------------------------------------ //
 // Create and Destroy Layer
 // ------------------------------------------------------------------------------------------------------------ //
 Layer* console_layer_create_with_buffer_size(GRect frame, int buffer_size);
 Layer* console_layer_create(GRect frame);      // Creates layer with 500 byte buffer
 
-// You can just use the standard layer_destroy to destroy a console_layer
-// Adding these for consistency
-#define console_layer_destroy(console_layer) layer_destroy(console_layer);
-#define console_layer_safe_destroy(console_layer) if (console_layer) { layer_destroy(console_layer); console_layer = NULL; }
+// BREAKING CHANGE: console_layer_destroy used to be a macro for layer_destroy; it's a function now, and consoles must be
+// destroyed with it instead of layer_destroy.  It cancels the redraw timer if a redraw is pending (see max_fps), saves
+// anything not yet saved (see Persistence), leaves its pool and frees whatever the console took from the heap (a grown
+// buffer, the row cache).  A console using none of those holds nothing outside its layer.
+void   console_layer_destroy(Layer *console_layer);
+#define console_layer_safe_destroy(console_layer) if (console_layer) { console_layer_destroy(console_layer); console_layer = NULL; }
+
+// Shared pool: layers created in a pool share its memory instead of each having a buffer of their own.  Each one gets
+// min_buffer_size bytes to start with and grows (up to max_buffer_size) as it fills, into free space or space taken back
+// from layers that haven't been written to for a while (down to their minimums).  The index that goes with a buffer
+// takes another half of its size (3/8 with CONSOLE_LAYER_NO_REPEATS), so a pool of 2000 bytes has room for about 1330
+// bytes of buffer in all.
+// Up to CONSOLE_LAYER_POOL_MAX_LAYERS (4) layers per pool.  Destroy the layers before the pool.
+typedef struct ConsoleLayerPool ConsoleLayerPool;
+ConsoleLayerPool* console_layer_pool_create   (size_t size);
+void              console_layer_pool_destroy  (ConsoleLayerPool *pool);
+Layer*            console_layer_create_in_pool(GRect frame, ConsoleLayerPool *pool, int min_buffer_size, int max_buffer_size);  // NULL if the pool can't fit min_buffer_size
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Buffer Size
+// ------------------------------------------------------------------------------------------------------------ //
+// Grows or shrinks a live layer's buffer, keeping the newest chunks that still fit.  A layer grown past the size it was
+// created with moves its buffer to the heap (and back into the layer if it's shrunk to fit again), so a layer that will
+// grow is best created small.  Pooled layers stay within their pool and quota.  Returns the size the buffer ends up.
+int  console_layer_set_buffer_size          (Layer *console_layer, int buffer_size);
+
+// Adaptive sizing: after a write leaves the buffer 3/4 full, it grows (256 bytes at a time, up to max_buffer_size) if
+// heap_headroom bytes would still be free on the heap afterwards, and a write that finds less than heap_headroom free
+// shrinks it (down to min_buffer_size).  heap_headroom = 0 turns it off.  Not for pooled layers.
+void console_layer_set_adaptive_buffer_size (Layer *console_layer, int min_buffer_size, int max_buffer_size, int heap_headroom);
+
+// Before a big allocation (such as loading an image): shrinks an adaptive layer until bytes more than its headroom are
+// free on the heap, or it's at its minimum.  Returns the size the buffer ends up.
+int  console_layer_make_heap_room           (Layer *console_layer, size_t bytes);
 
 // ------------------------------------------------------------------------------------------------------------ //
 // Gets
 // ------------------------------------------------------------------------------------------------------------ //
+#ifndef CONSOLE_LAYER_NO_BORDER
 int            console_layer_get_border_thickness       (Layer *console_layer);
 bool           console_layer_get_border_enabled         (Layer *console_layer);
 GColor         console_layer_get_border_color           (Layer *console_layer);
+#endif
 
+#ifndef CONSOLE_LAYER_NO_HEADER
 GColor         console_layer_get_header_background_color(Layer *console_layer);
 GTextAlignment console_layer_get_header_text_alignment  (Layer *console_layer);
 GColor         console_layer_get_header_text_color      (Layer *console_layer);
 bool           console_layer_get_header_enabled         (Layer *console_layer);
 GFont          console_layer_get_header_font            (Layer *console_layer);
 char*          console_layer_get_header_text            (Layer *console_layer);
+#endif
 
 GColor         console_layer_get_layer_background_color (Layer *console_layer);
 GColor         console_layer_get_layer_text_color       (Layer *console_layer);
@@ -40,27 +113,49 @@ GTextAlignment console_layer_get_layer_alignment        (Layer *console_layer);
 bool           console_layer_get_layer_word_wrap        (Layer *console_layer);
 GFont          console_layer_get_layer_font             (Layer *console_layer);
 
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
 GColor         console_layer_get_background_color       (Layer *console_layer);
 GColor         console_layer_get_text_color             (Layer *console_layer);
 GTextAlignment console_layer_get_alignment              (Layer *console_layer);
 int            console_layer_get_word_wrap              (Layer *console_layer);
 GFont          console_layer_get_font                   (Layer *console_layer);
+#endif
 
 bool           console_layer_get_dirty_automatically    (Layer *console_layer);
+bool           console_layer_get_incremental_redraw     (Layer *console_layer);
+bool           console_layer_get_follow_tail            (Layer *console_layer);
+uint8_t        console_layer_get_max_fps                (Layer *console_layer);
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+bool           console_layer_get_compact_text           (Layer *console_layer);
+#endif
+#ifndef CONSOLE_LAYER_NO_REPEATS
+bool           console_layer_get_collapse_repeats       (Layer *console_layer);
+#endif
+#ifdef PBL_ROUND
+bool           console_layer_get_round_layout           (Layer *console_layer);
+#endif
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+size_t         console_layer_get_row_cache_size         (Layer *console_layer);
+#endif
+int            console_layer_get_buffer_size            (Layer *console_layer);  // Changes as a pooled or adaptive layer grows and shrinks
 
 // ------------------------------------------------------------------------------------------------------------ //
 // Sets
 // ------------------------------------------------------------------------------------------------------------ //
+#ifndef CONSOLE_LAYER_NO_HEADER
 void console_layer_set_header_background_color(Layer *console_layer, GColor         header_background_color);
 void console_layer_set_header_text_alignment  (Layer *console_layer, GTextAlignment header_text_alignment);
 void console_layer_set_header_text_color      (Layer *console_layer, GColor         header_text_color);
 void console_layer_set_header_enabled         (Layer *console_layer, bool           header_enabled);
 void console_layer_set_header_font            (Layer *console_layer, GFont          header_font);
 void console_layer_set_header_text            (Layer *console_layer, char          *header_text);
+#endif
 
+#ifndef CONSOLE_LAYER_NO_BORDER
 void console_layer_set_border_thickness       (Layer *console_layer, int            border_thickness);
 void console_layer_set_border_enabled         (Layer *console_layer, bool           border_enabled);
 void console_layer_set_border_color           (Layer *console_layer, GColor         border_color);
+#endif
 
 void console_layer_set_layer_background_color (Layer *console_layer, GColor         layer_background_color);
 void console_layer_set_layer_text_color       (Layer *console_layer, GColor         layer_text_color);
@@ -68,23 +163,70 @@ void console_layer_set_layer_alignment        (Layer *console_layer, GTextAlignm
 void console_layer_set_layer_word_wrap        (Layer *console_layer, bool           layer_word_wrap);
 void console_layer_set_layer_font             (Layer *console_layer, GFont          layer_font);
 
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
 void console_layer_set_background_color       (Layer *console_layer, GColor         background_color);
 void console_layer_set_text_color             (Layer *console_layer, GColor         text_color);
 void console_layer_set_alignment              (Layer *console_layer, GTextAlignment alignment);
 void console_layer_set_word_wrap              (Layer *console_layer, int            word_wrap);
 void console_layer_set_font                   (Layer *console_layer, GFont          font);
+#endif
 
 void console_layer_set_dirty_automatically    (Layer *console_layer, bool           dirty_layer_after_writing);
 
+// Incremental redraw: when only new rows have been written since the last frame, move what's already on screen up and
+// only draw the new rows.  Falls back to repainting everything if anything else changed or drew over the layer.
+void console_layer_set_incremental_redraw     (Layer *console_layer, bool           incremental_redraw);
+
+// Max FPS: writes mark the layer dirty at most max_fps times a second (0 = every write, the default).  The first write
+// after a quiet spell still draws straight away, the rest are held with an AppTimer and drawn together.
+// Either way, writes to a hidden layer (or one whose window isn't on top) aren't laid out until it's drawn again.
+void console_layer_set_max_fps                (Layer *console_layer, uint8_t        max_fps);
+
+#ifndef CONSOLE_LAYER_NO_COMPACT_TEXT
+// Compact text: text written from now on is stored with common letter pairs and words (from a built-in table) packed
+// into one byte each, which fits about 40% more lines of log text in the same buffer (see the lines_kept benchmarks).
+// Only chunks that are on screen are unpacked, into the scratch buffer, as they're drawn.  Text that isn't plain ASCII (such as UTF-8 and
+// emoji) is stored as it is.
+void console_layer_set_compact_text           (Layer *console_layer, bool           compact_text);
+#endif
+
+#ifndef CONSOLE_LAYER_NO_REPEATS
+// Collapse repeats: a line written exactly like the newest one (same text, style and image, ending in a newline) isn't
+// stored again, it just adds to a count on the newest line, which is drawn on the end of it as "×N".  A sensor or retry
+// loop writing the same line over and over then takes no more room, and only its row is redrawn.
+void console_layer_set_collapse_repeats       (Layer *console_layer, bool           collapse_repeats);
+#endif
+
+#ifdef PBL_ROUND
+// Round layout: each row is wrapped to the widest part of the round screen across it (less near the top and bottom),
+// instead of the whole width of the layer, so a layer can go out nearer the edge of the screen without rows being cut
+// off by it.  Rows where the screen is less than CONSOLE_LAYER_ROUND_MIN_WIDTH (40) pixels across are left blank.
+// The layer's own background, header and border are still square.  Incremental redraw is off while it's on, since rows
+// change width as they move up.
+void console_layer_set_round_layout           (Layer *console_layer, bool           round_layout);
+#endif
+
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+// Row cache: keeps a copy of the newest rows as they were drawn, up to row_cache_size bytes (a row costs the width of the
+// layer times its height, plus 16), and copies a row back into the frame buffer instead of drawing it again while it's
+// unchanged, such as when scrolling, with round layout or when the whole layer is repainted.  Older rows are dropped first.
+// Changing the layer's style or width, the view level or the highlighted match throws them all out.  The layer's
+// background color can't be clear.  The whole row_cache_size is allocated here (drawing never allocates), and setting a
+// new size throws the rows out.  0 (the default) turns it off and frees it.
+void console_layer_set_row_cache_size         (Layer *console_layer, size_t         row_cache_size);
+#endif
+
 // ------------------------------------------------------------------------------------------------------------ //
 // Group Sets
 // ------------------------------------------------------------------------------------------------------------ //
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
 void console_layer_set_text_style (Layer         *console_layer,
                                    GColor         text_color,
                                    GColor         background_color,
                                    GFont          font,
                                    GTextAlignment alignment,
                                    int            word_wrap);
+#endif
 
 void console_layer_set_layer_style (Layer         *console_layer,
                                     GColor         layer_text_color,
@@ -94,17 +236,65 @@ void console_layer_set_layer_style (Layer         *console_layer,
                                     bool           layer_word_wrap,
                                     bool           dirty_layer_after_writing);
 
+#ifndef CONSOLE_LAYER_NO_BORDER
 void console_layer_set_border_style(Layer         *console_layer,
                                     bool           border_enabled,
                                     GColor         border_color,
                                     int            border_thickness);
+#endif
 
+#ifndef CONSOLE_LAYER_NO_HEADER
 void console_layer_set_header_style(Layer         *console_layer,
                                     bool           header_enabled,
                                     GColor         header_text_color,
                                     GColor         header_background_color,
                                     GFont          header_font,
                                     GTextAlignment header_text_alignment);
+#endif
+
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+// ------------------------------------------------------------------------------------------------------------ //
+// Style Table
+// ------------------------------------------------------------------------------------------------------------ //
+// Each chunk of text stores a one byte style ID instead of its colors, font, alignment and word wrap.  Styles are added to
+// the layer's table automatically as they're written in, but registering one up front keeps it from ever being replaced.
+// The table holds CONSOLE_LAYER_MAX_STYLES styles (16 by default, define it before compiling console.c to change, max 16).
+// ------------------------------------------------------------------------------------------------------------ //
+int  console_layer_register_style   (Layer *console_layer, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap);  // Returns the style ID, or -1 if too many are registered
+void console_layer_set_text_style_id(Layer *console_layer, int style_id);  // Same as console_layer_set_text_style with a registered style
+#endif
+
+#ifndef CONSOLE_LAYER_NO_LEVELS
+// ------------------------------------------------------------------------------------------------------------ //
+// Levels
+// ------------------------------------------------------------------------------------------------------------ //
+// Every chunk is written at a level, kept in its style byte: the one set with console_layer_set_level (Info to start
+// with), or the message's level for CONSOLE_LOG.  A layer can draw just the chunks at or above one level, and hold on to
+// the chunks at or above another when the buffer's full and there are less important ones to evict instead.
+// ------------------------------------------------------------------------------------------------------------ //
+typedef enum {
+  ConsoleLayerLevelDebug,    // (and CONSOLE_LOG's VERBOSE)
+  ConsoleLayerLevelInfo,
+  ConsoleLayerLevelWarning,
+  ConsoleLayerLevelError,
+} ConsoleLayerLevel;
+
+void              console_layer_set_level     (Layer *console_layer, ConsoleLayerLevel level);       // Level of the text written from now on
+ConsoleLayerLevel console_layer_get_level     (Layer *console_layer);
+void              console_layer_set_view_level(Layer *console_layer, ConsoleLayerLevel view_level);  // Draw only chunks at this level or above (Debug: all, the default)
+ConsoleLayerLevel console_layer_get_view_level(Layer *console_layer);
+
+// Keep level: evicting makes room by dropping the oldest chunk below keep_level, moving the older chunks at or above it up
+// over the gap, as long as those take up no more than CONSOLE_LAYER_MAX_KEPT_PERCENT (50%) of the buffer.  Past that (or
+// with keep_level Debug, the default) the oldest chunk goes, whatever its level.  With it on, printf formats into the
+// scratch buffer first.
+// Cost: every write that evicts behind kept chunks moves them all, up to half the buffer and as many index entries, so
+// it grows with the buffer.  With one line in ten kept (write_short_keep in make bench-run), a write takes about 4 times
+// as long as without keeping at 500 bytes, and about 15 times at 4000.  It's meant for rare levels such as errors, in
+// small buffers; define CONSOLE_LAYER_MAX_KEPT_PERCENT lower when compiling console.c to cap how much is moved.
+void              console_layer_set_keep_level(Layer *console_layer, ConsoleLayerLevel keep_level);
+ConsoleLayerLevel console_layer_get_keep_level(Layer *console_layer);
+#endif
 
 // ------------------------------------------------------------------------------------------------------------ //
 // Write Text
@@ -114,20 +304,201 @@ void console_layer_set_header_style(Layer         *console_layer,
 //
 // Images are NOT copied to the buffer (only a pointer) so you gotta keep the image in memory if it's still displayed on screen
 // Also, btw, header text isn't stored in the layer either, just a pointer.
+//
+// With CONSOLE_LAYER_NO_PER_CHUNK_STYLE, the _styled functions ignore their style arguments (everything's drawn in the
+// layer's style).  With CONSOLE_LAYER_NO_IMAGES, console_layer_write_text_and_image_styled ignores its image.
 // ------------------------------------------------------------------------------------------------------------ //
 void console_layer_write_text_and_image_styled  (Layer *console_layer, GBitmap *image, char *text, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap, bool advance);
+#ifndef CONSOLE_LAYER_NO_IMAGES
 void console_layer_write_text_and_image         (Layer *console_layer, GBitmap *image, char *text);
 void console_layer_writeln_text_and_image       (Layer *console_layer, GBitmap *image, char *text);
 
 void console_layer_write_image_styled           (Layer *console_layer, GBitmap *image, GColor background_color, GTextAlignment alignment, bool advance);
 void console_layer_write_image                  (Layer *console_layer, GBitmap *image);
 void console_layer_writeln_image                (Layer *console_layer, GBitmap *image);
+#endif
 void console_layer_write_text_styled            (Layer *console_layer, char *text, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap, bool advance);
 void console_layer_write_text                   (Layer *console_layer, char *text);
 void console_layer_writeln_text                 (Layer *console_layer, char *text);
 
 void console_layer_clear        (Layer *console_layer);
 
+// Batches: between begin and end, the layer is only marked dirty once (at the end) and text written in the same style
+// as the text before it on the same row shares its header in the buffer.  Batches can be nested.
+void console_layer_begin_batch  (Layer *console_layer);
+void console_layer_end_batch    (Layer *console_layer);
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Scrollback
+// ------------------------------------------------------------------------------------------------------------ //
+// By default the console follows the tail: the newest row is at the bottom.  Scrolling back (e.g. with the UP button)
+// holds the view still while more text is written, until it's scrolled forward to the bottom again.
+// ------------------------------------------------------------------------------------------------------------ //
+void console_layer_scroll_by        (Layer *console_layer, int  rows);         // rows > 0: back (older), rows < 0: forward (newer)
+void console_layer_scroll_to_bottom (Layer *console_layer);                    // Back to the newest row, and follow the tail
+void console_layer_set_follow_tail  (Layer *console_layer, bool follow_tail);  // false: stop where it is
+
+#ifndef CONSOLE_LAYER_NO_FIND
+// ------------------------------------------------------------------------------------------------------------ //
+// Find
+// ------------------------------------------------------------------------------------------------------------ //
+// Searches the text in the buffer where it is (nothing's copied out), newest chunk first.  A match has to be inside one
+// chunk's text.  Finding one scrolls back to it if it isn't on screen, and draws it highlighted (in its background color
+// on its text color) until the highlight's cleared or another match is found.  In CONSOLE_LAYER_FONT_MONO that's just
+// the match; in other fonts it's the whole chunk it's in (Pebble doesn't say where in wrapped text a character goes).
+// Hidden chunks (see console_layer_set_view_level) are passed over, and the "×N" of a repeated line isn't searched.
+// Needles can be up to 255 bytes long.  A match is found again by the sequence number of its chunk (the same one
+// console_layer_export uses), so find_next and find_previous still work after more text's been written.
+// ------------------------------------------------------------------------------------------------------------ //
+typedef struct ConsoleMatch {
+  uint32_t seq;     // Sequence number of the chunk it's in
+  uint16_t index;   // Where it starts in the chunk's text (in bytes, unpacked if it's compact text)
+  uint16_t length;  // Length of the needle
+} ConsoleMatch;
+
+bool console_layer_find           (Layer *console_layer, const char *needle, ConsoleMatch *match);  // Newest match. Returns false if there isn't one (and leaves match alone)
+bool console_layer_find_previous  (Layer *console_layer, const char *needle, ConsoleMatch *match);  // Next match older than match
+bool console_layer_find_next      (Layer *console_layer, const char *needle, ConsoleMatch *match);  // Next match newer than match
+void console_layer_clear_highlight(Layer *console_layer);
+#endif
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Write Formatted Text
+// ------------------------------------------------------------------------------------------------------------ //
+// Same as the write_text functions, but the text is formatted (like printf) straight into the console_layer's buffer,
+// so there's no need for a buffer of your own to snprintf into first.
+// ------------------------------------------------------------------------------------------------------------ //
+void console_layer_printf_styled                (Layer *console_layer, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap, bool advance, const char *format, ...);
+void console_layer_vprintf_styled               (Layer *console_layer, GColor text_color, GColor background_color, GFont font, GTextAlignment alignment, int word_wrap, bool advance, const char *format, va_list args);
+void console_layer_printf                       (Layer *console_layer, const char *format, ...);
+void console_layer_printfln                     (Layer *console_layer, const char *format, ...);
+void console_layer_vprintf                      (Layer *console_layer, const char *format, va_list args);
+void console_layer_vprintfln                    (Layer *console_layer, const char *format, va_list args);
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Persistence
+// ------------------------------------------------------------------------------------------------------------ //
+// Mirrors the layer's text into persistent storage so it's still there next time the app starts.  Call it right after
+// creating the layer: it restores what was saved (if it was saved by a layer with the same buffer size) and returns
+// whether it did.  Only what's changed is saved, CONSOLE_LAYER_PERSIST_FLUSH_MS (2 seconds) after a write, and the rest
+// when the layer is destroyed.  Images and fonts can't be saved (they're pointers): restored text is drawn in the
+// layer's font, and without its images.
+// Uses key first_key, then one for the style table (more if CONSOLE_LAYER_MAX_STYLES is raised), then one per 256 bytes
+// of chunk index and buffer (a 500 byte buffer and its index are 756 bytes, so 3 keys).  An app only gets 4KB of
+// persistent storage in all, so a 500 byte buffer takes about 1KB, and buffers much over 2500 bytes won't fit.
+// ------------------------------------------------------------------------------------------------------------ //
+bool console_layer_enable_persistence(Layer *console_layer, uint32_t first_key);  // Returns true if it restored the text
+void console_layer_persist_flush     (Layer *console_layer);                      // Save now (e.g. in deinit if the layer isn't destroyed)
+
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Logging
+// ------------------------------------------------------------------------------------------------------------ //
+// CONSOLE_LOG(level, format, ...) sends a message to APP_LOG and writes it on the log layer (if one's been set) in that
+// level's style.  level is one of ERROR, WARNING, INFO, DEBUG or VERBOSE, e.g.:
+//   CONSOLE_LOG(ERROR, "Dictation Error: %d", status);
+//
+// Levels less important than CONSOLE_LOG_LEVEL (define it before including console.h, default DEBUG) are compiled
+// out completely: the arguments aren't evaluated and the format string isn't in the binary.  console_log_set_level
+// filters the ones that are compiled in at runtime.
+// ------------------------------------------------------------------------------------------------------------ //
+#define CONSOLE_LOG_LEVEL_NONE    0    // Same values as AppLogLevel
+#define CONSOLE_LOG_LEVEL_ERROR   1
+#define CONSOLE_LOG_LEVEL_WARNING 50
+#define CONSOLE_LOG_LEVEL_INFO    100
+#define CONSOLE_LOG_LEVEL_DEBUG   200
+#define CONSOLE_LOG_LEVEL_VERBOSE 255
+
+#ifndef CONSOLE_LOG_LEVEL
+  #define CONSOLE_LOG_LEVEL CONSOLE_LOG_LEVEL_DEBUG
+#endif
+
+#define CONSOLE_LOG(level, ...) CONSOLE_LOG_##level(__VA_ARGS__)
+
+#if CONSOLE_LOG_LEVEL >= CONSOLE_LOG_LEVEL_ERROR
+  #define CONSOLE_LOG_ERROR(...)   console_log(CONSOLE_LOG_LEVEL_ERROR,   __FILE__, __LINE__, __VA_ARGS__)
+#else
+  #define CONSOLE_LOG_ERROR(...)
+#endif
+#if CONSOLE_LOG_LEVEL >= CONSOLE_LOG_LEVEL_WARNING
+  #define CONSOLE_LOG_WARNING(...) console_log(CONSOLE_LOG_LEVEL_WARNING, __FILE__, __LINE__, __VA_ARGS__)
+#else
+  #define CONSOLE_LOG_WARNING(...)
+#endif
+#if CONSOLE_LOG_LEVEL >= CONSOLE_LOG_LEVEL_INFO
+  #define CONSOLE_LOG_INFO(...)    console_log(CONSOLE_LOG_LEVEL_INFO,    __FILE__, __LINE__, __VA_ARGS__)
+#else
+  #define CONSOLE_LOG_INFO(...)
+#endif
+#if CONSOLE_LOG_LEVEL >= CONSOLE_LOG_LEVEL_DEBUG
+  #define CONSOLE_LOG_DEBUG(...)   console_log(CONSOLE_LOG_LEVEL_DEBUG,   __FILE__, __LINE__, __VA_ARGS__)
+#else
+  #define CONSOLE_LOG_DEBUG(...)
+#endif
+#if CONSOLE_LOG_LEVEL >= CONSOLE_LOG_LEVEL_VERBOSE
+  #define CONSOLE_LOG_VERBOSE(...) console_log(CONSOLE_LOG_LEVEL_VERBOSE, __FILE__, __LINE__, __VA_ARGS__)
+#else
+  #define CONSOLE_LOG_VERBOSE(...)
+#endif
+
+void console_log_set_layer(Layer *console_layer);  // NULL: only APP_LOG
+void console_log_set_level(uint8_t level);          // e.g. CONSOLE_LOG_LEVEL_WARNING: drop INFO and below (default: all)
+#ifndef CONSOLE_LAYER_NO_PER_CHUNK_STYLE
+void console_log_set_style(uint8_t level, GColor text_color, GColor background_color);  // Defaults: errors red, warnings orange
+#endif
+
+// Used by CONSOLE_LOG.  The log layer gets the whole message; APP_LOG's copy is cut to CONSOLE_LOG_MAX_LENGTH (128)
+// characters.  console_vlog is for passing on a va_list from a function of your own.
+void console_log (uint8_t level, const char *src_filename, int src_line_number, const char *format, ...);
+void console_vlog(uint8_t level, const char *src_filename, int src_line_number, const char *format, va_list args);
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Export
+// ------------------------------------------------------------------------------------------------------------ //
+// Sends a layer's text to the phone over AppMessage, oldest chunk first, packed into messages as big as the outbox
+// (open it with app_message_open first).  Each message is one batch, sent when the one before it has been delivered:
+//   CONSOLE_LAYER_EXPORT_KEY      uint32: sequence number of the chunk the batch starts in
+//   CONSOLE_LAYER_EXPORT_KEY + 1  data:   chunk text, each chunk's ending in a 0.  A chunk too big for the rest of a
+//                                         batch carries on in the next one, which then starts with the same number.
+// Sequence numbers go up by one per chunk, so a jump means chunks were evicted before they could be sent.
+// The export replaces the app's outbox sent and failed handlers until it's done, then puts them back.  Failed
+// messages are tried again CONSOLE_LAYER_EXPORT_RETRIES (3) times, then it gives up.  Either way, callback gets the
+// sequence number to carry on from next time (e.g. when more has been written, or the phone's back in range).
+// ------------------------------------------------------------------------------------------------------------ //
+#ifndef CONSOLE_LAYER_EXPORT_KEY
+#define CONSOLE_LAYER_EXPORT_KEY 0xC0C0
+#endif
+
+typedef void (*ConsoleLayerExportCallback)(Layer *console_layer, uint32_t next_seq, bool finished);  // finished: false if it gave up
+
+bool console_layer_export       (Layer *console_layer, uint32_t from_seq, ConsoleLayerExportCallback callback);  // from_seq 0: everything.  false if an export's already going
+void console_layer_export_cancel(Layer *console_layer);                                                          // Stops without calling back
+
+// ------------------------------------------------------------------------------------------------------------ //
+// Stats
+// ------------------------------------------------------------------------------------------------------------ //
+// Counters showing how hard a console_layer is working.  They're only kept if CONSOLE_LAYER_STATS is defined (here or
+// when compiling), otherwise they cost nothing and console_layer_get_stats returns false with everything 0.
+// ------------------------------------------------------------------------------------------------------------ //
+//#define CONSOLE_LAYER_STATS
+
+typedef struct ConsoleLayerStats {
+  uint32_t bytes_written;         // Bytes put in the buffer (headers, text, newlines and terminating 0s)
+  uint32_t chunks_written;
+  uint32_t chunks_evicted;        // Oldest chunks dropped to make room
+  uint32_t chunks_repeated;       // Lines counted as a repeat of the newest instead of written (see console_layer_set_collapse_repeats)
+  uint32_t redraws;               // Times console_layer_update has run
+  uint32_t rows_drawn;            // Rows drawn over all redraws (rows_drawn / redraws = rows per redraw)
+  uint16_t max_rows_drawn;        // Most rows drawn in one redraw
+  uint32_t rows_cached;           // Rows copied back from the row cache instead of drawn (see console_layer_set_row_cache_size)
+  uint32_t measure_calls;         // Calls to graphics_text_layout_get_content_size
+  uint32_t scratch_allocs;        // Times text had to be put together in the scratch buffer (allocated with the layer)
+  uint32_t update_ms;             // Total time spent in console_layer_update
+  uint16_t max_update_ms;         // Longest console_layer_update
+} ConsoleLayerStats;
+
+bool console_layer_get_stats  (Layer *console_layer, ConsoleLayerStats *stats);
+void console_layer_reset_stats(Layer *console_layer);
 
 // ------------------------------------------------------------------------------------------------------------ //
 
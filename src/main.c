@@ -10,15 +10,18 @@
 static Window *main_window;
 static Layer *top_console_layer;
 static Layer *bottom_console_layer;
+static ConsoleLayerPool *console_pool;  // Both consoles share one pool: whichever's busy gets the room
 static GBitmap *smile;
 static bool emulator;
 static GRect outer_rect;
 
 
-static void error_msg(char *msg) {
-  printf("Displaying Error: %s", msg);
+static void error_msg(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
   console_layer_write_text_styled(top_console_layer, "Dictation Error", GColorBlack, GColorRed, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD), GTextAlignmentCenter, true, true);
-  console_layer_writeln_text(bottom_console_layer, msg);
+  console_vlog(CONSOLE_LOG_LEVEL_ERROR, __FILE__, __LINE__, format, args);
+  va_end(args);
 }
 
 
@@ -41,8 +44,8 @@ static char* watch_type() {
 // ------------------------------------------------------------------------ //
 //  Dictation API Functions
 // ------------------------------------------------------------------------ //
+#define DICTATION_BUFFER_SIZE 512
 static DictationSession *dictation_session = NULL;
-static char dictation_text[512];
 static const char* DictationSessionStatusError[] = {
   "Transcription successful, with a valid result.",
   "User rejected transcription and exited UI.",
@@ -57,20 +60,17 @@ static const char* DictationSessionStatusError[] = {
 
 static void dictation_session_callback(DictationSession *session, DictationSessionStatus status, char *transcription, void *context) {
   if(status == DictationSessionStatusSuccess) {
-    snprintf(dictation_text, sizeof(dictation_text), "%s", transcription);
-    printf("Dictation Text: %s", dictation_text);
-    console_layer_writeln_text(top_console_layer, dictation_text);
-    console_layer_writeln_text(bottom_console_layer, "Dictation Successful");
+    CONSOLE_LOG(DEBUG, "Dictation Text: %s", transcription);
+    console_layer_writeln_text(top_console_layer, transcription);
+    CONSOLE_LOG(INFO, "Dictation Successful");
   } else {
-    printf("Dictation Error: %s", DictationSessionStatusError[status]);
-    snprintf(dictation_text, sizeof(dictation_text), "Dictation Error: %s", DictationSessionStatusError[status]);
-    error_msg(dictation_text);
+    error_msg("Dictation Error: %s", DictationSessionStatusError[status]);
   }
 }
 
 
 static void init_dictation() {
-  dictation_session = dictation_session_create(sizeof(dictation_text), dictation_session_callback, NULL);
+  dictation_session = dictation_session_create(DICTATION_BUFFER_SIZE, dictation_session_callback, NULL);
 }
 
 static void destroy_dictation() {
@@ -82,8 +82,14 @@ static void destroy_dictation() {
 // ------------------------------------------------------------------------ //
 //  Button Functions
 // ------------------------------------------------------------------------ //
-static void up_click_handler(ClickRecognizerRef recognizer, void *context) { //   UP   button
+static void up_click_handler(ClickRecognizerRef recognizer, void *context) { //   UP   button pressed briefly
+  console_layer_scroll_by(top_console_layer, 1);
+}
+
+static void up_long_click_handler(ClickRecognizerRef recognizer, void *context) { //   UP   button held for 500ms
   static uint8_t prevchat = 3;
+  console_layer_begin_batch(top_console_layer);
+  console_layer_begin_batch(bottom_console_layer);
   
   if(rand()%2) {
     if(prevchat!=1) {
@@ -124,6 +130,9 @@ static void up_click_handler(ClickRecognizerRef recognizer, void *context) { //
       console_layer_writeln_text(bottom_console_layer, "                           a picture");
     break;
   }
+
+  console_layer_end_batch(top_console_layer);
+  console_layer_end_batch(bottom_console_layer);
 }
 
 static void sl_click_handler(ClickRecognizerRef recognizer, void *context) { // SELECT button
@@ -133,8 +142,16 @@ static void sl_click_handler(ClickRecognizerRef recognizer, void *context) { //
     PBL_IF_MICROPHONE_ELSE(dictation_session_start(dictation_session), error_msg("No Microphone"));
 }
 
+static void sl_long_click_handler(ClickRecognizerRef recognizer, void *context) { // SELECT button held for 500ms
+  static ConsoleMatch match;  // Steps back through the matches, starting again from the newest after the oldest
+  if(!console_layer_find_previous(top_console_layer, "weird", &match) && !console_layer_find(top_console_layer, "weird", &match))
+    console_layer_writeln_text(bottom_console_layer, "Nothing weird found");
+}
+
 static void dn_click_handler(ClickRecognizerRef recognizer, void *context) { //  DOWN  button pressed briefly
-  if(layer_get_hidden(bottom_console_layer)) {
+  if(!console_layer_get_follow_tail(top_console_layer)) {
+    console_layer_scroll_by(top_console_layer, -1);  // Scrolled back: scroll forward instead
+  } else if(layer_get_hidden(bottom_console_layer)) {
     layer_set_hidden(bottom_console_layer, false);
     console_layer_writeln_text(bottom_console_layer, "Log Visible");
     layer_set_frame(top_console_layer, GRect(outer_rect.origin.x, outer_rect.origin.y, outer_rect.size.w, outer_rect.size.h - BOTTOM_CONSOLE_HEIGHT - CONSOLE_LAYER_SEPARATION));
@@ -154,7 +171,9 @@ static void dn_long_click_handler(ClickRecognizerRef recognizer, void *context)
 
 static void click_config_provider(void *context) {
   window_single_click_subscribe(BUTTON_ID_UP, up_click_handler);
+  window_long_click_subscribe(BUTTON_ID_UP, 0, up_long_click_handler, NULL);
   window_single_click_subscribe(BUTTON_ID_SELECT, sl_click_handler);
+  window_long_click_subscribe(BUTTON_ID_SELECT, 0, sl_long_click_handler, NULL);
   window_single_click_subscribe(BUTTON_ID_DOWN, dn_click_handler);
   window_long_click_subscribe(BUTTON_ID_DOWN, 0, dn_long_click_handler, NULL);
 }
@@ -169,28 +188,40 @@ static void main_window_load(Window *window) {
   // Create Console Layers
   Layer *root_layer = window_get_root_layer(window);
   
-  outer_rect = grect_inset(layer_get_frame(window_get_root_layer(window)), GEdgeInsets(PBL_IF_ROUND_ELSE(26, 10)));
+  outer_rect = grect_inset(layer_get_frame(window_get_root_layer(window)), GEdgeInsets(PBL_IF_ROUND_ELSE(14, 10)));  // (Round layout keeps rows off the bezel)
   
-  top_console_layer = console_layer_create(GRect(outer_rect.origin.x, outer_rect.origin.y, outer_rect.size.w, outer_rect.size.h - BOTTOM_CONSOLE_HEIGHT - CONSOLE_LAYER_SEPARATION));
-  bottom_console_layer = console_layer_create(GRect(outer_rect.origin.x, outer_rect.origin.y + outer_rect.size.h - BOTTOM_CONSOLE_HEIGHT, outer_rect.size.w, BOTTOM_CONSOLE_HEIGHT));
+  console_pool = console_layer_pool_create(1400);
+  top_console_layer = console_layer_create_in_pool(GRect(outer_rect.origin.x, outer_rect.origin.y, outer_rect.size.w, outer_rect.size.h - BOTTOM_CONSOLE_HEIGHT - CONSOLE_LAYER_SEPARATION), console_pool, 200, 900);
+  bottom_console_layer = console_layer_create_in_pool(GRect(outer_rect.origin.x, outer_rect.origin.y + outer_rect.size.h - BOTTOM_CONSOLE_HEIGHT, outer_rect.size.w, BOTTOM_CONSOLE_HEIGHT), console_pool, 200, 900);
   
   layer_add_child(root_layer, top_console_layer);
   layer_add_child(root_layer, bottom_console_layer);
 
   // Configure Console Layers
   console_layer_set_layer_background_color(top_console_layer, GColorWhite);  // default is clear background
-  console_layer_set_layer_style(bottom_console_layer, GColorWhite, GColorBlack, fonts_get_system_font(FONT_KEY_GOTHIC_09), GTextAlignmentLeft, true, true);
+  console_layer_set_layer_style(bottom_console_layer, GColorWhite, GColorBlack, CONSOLE_LAYER_FONT_MONO, GTextAlignmentLeft, true, true);  // Log lines in the built-in mono font
+  console_layer_set_compact_text(bottom_console_layer, true);  // Log lines are plain ASCII, so more of them fit
+  console_layer_set_collapse_repeats(bottom_console_layer, true);  // A line logged over and over shows once, as "×N"
+  console_layer_set_keep_level(bottom_console_layer, ConsoleLayerLevelError);  // Errors outlast the debug chatter
+#ifdef PBL_ROUND
+  console_layer_set_round_layout(top_console_layer, true);     // Each row as wide as the screen is where it is
+  console_layer_set_round_layout(bottom_console_layer, true);
+#endif
+#ifndef CONSOLE_LAYER_NO_ROW_CACHE
+  console_layer_set_row_cache_size(top_console_layer, 8192);  // Chat rows are copied back, not drawn again (not on aplite)
+#endif
 
   console_layer_set_header_enabled(top_console_layer, true);
   console_layer_set_border_enabled(top_console_layer, true);
   console_layer_set_header_background_color(top_console_layer, PBL_IF_COLOR_ELSE(GColorVividCerulean, GColorBlack));
   console_layer_set_header_text_color(top_console_layer, PBL_IF_COLOR_ELSE(GColorBlack, GColorWhite));
   console_layer_set_header_text(top_console_layer, "Chat");
+  console_log_set_layer(bottom_console_layer);  // CONSOLE_LOG goes to the log layer as well as APP_LOG
   
   
   // Add some text to Console Layers
   console_layer_write_text_styled(top_console_layer, "Welcome to\nConsole Chat", GColorInherit, GColorInherit, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD), GTextAlignmentCenter, true, true);
-  console_layer_writeln_text(bottom_console_layer, "Program Started.");
+  CONSOLE_LOG(INFO, "Program Started.");
   
   // Detect and log watch type
   console_layer_write_text(bottom_console_layer, "Detected:");
@@ -199,8 +230,9 @@ static void main_window_load(Window *window) {
 
 
 static void main_window_unload(Window *window) {
-  layer_destroy(top_console_layer);
-  layer_destroy(bottom_console_layer);
+  console_layer_destroy(top_console_layer);
+  console_layer_destroy(bottom_console_layer);
+  console_layer_pool_destroy(console_pool);
 }
 
 
@@ -223,7 +255,7 @@ static void init() {
   emulator = watch_info_get_model()==WATCH_INFO_MODEL_UNKNOWN;
   if(emulator) {
     light_enable(true);  // Good colors on emulator
-    LOG("Emulator Detected: Turning Backlight On");
+    CONSOLE_LOG(DEBUG, "Emulator Detected: Turning Backlight On");
   }
 }
 
@@ -1,11 +1,10 @@
 #pragma once
 #include <pebble.h>
-#define logging true  // Enable/Disable logging for debugging
-//Note: printf uses APP_LOG_LEVEL_DEBUG
-#if logging
-  #define LOG(...) (printf(__VA_ARGS__))
+#define logging true  // Enable/Disable debug logging (CONSOLE_LOG DEBUG and VERBOSE)
+#if logging  // (Numbers, not console.h's names, so it doesn't matter which is included first)
+  #define CONSOLE_LOG_LEVEL 255  // CONSOLE_LOG_LEVEL_VERBOSE
 #else
-  #define LOG(...)
+  #define CONSOLE_LOG_LEVEL 100  // CONSOLE_LOG_LEVEL_INFO
 #endif
 
 // =========================================================================================================== //